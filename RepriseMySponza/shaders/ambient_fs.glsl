@@ -1,18 +1,15 @@
 #version 330
 
-#define MAX_INSTANCE_COUNT 64
-
 
 //----------------------Structures----------------------
 
-struct InstanceData
+struct MaterialData
 {
-	mat4 mvpXform;
-	mat4 modelXform;
 	vec3 diffuse;
 	float shininess;
 	vec3 specular;
 	int isShiny;
+	int textureLayer;
 };
 
 
@@ -20,16 +17,17 @@ struct InstanceData
 
 layout (std140) uniform cpp_PerFrameUniforms
 {
+	mat4 cpp_ViewProjectionXform;
 	vec3 cpp_CameraPos;
 	vec3 cpp_AmbientIntensity;
 };
 
-layout(std140) uniform cpp_PerModelUniforms
+layout(std140) uniform cpp_MaterialUniforms
 {
-	InstanceData cpp_Instances[MAX_INSTANCE_COUNT];
+	MaterialData cpp_Materials[MAX_MATERIAL_COUNT];
 };
 
-uniform sampler2D cpp_Texture;
+uniform sampler2DArray cpp_Texture;
 
 
 //----------------------In Variables----------------------
@@ -38,6 +36,7 @@ in vec3 vs_Position;
 in vec3 vs_Normal;
 in vec2 vs_TextureCoord;
 flat in int vs_InstanceID;
+flat in int vs_MaterialIndex;
 
 
 //----------------------Out Variables----------------------
@@ -53,7 +52,7 @@ void main(void)
 	vec4 colour = vec4(cpp_AmbientIntensity, 0.0);
 
 	// Applying the texture for the fragment.
-	colour *= texture(cpp_Texture, vs_TextureCoord);
+	colour *= texture(cpp_Texture, vec3(vs_TextureCoord, cpp_Materials[vs_MaterialIndex].textureLayer));
 
 	// Passing the fragment colour to OpenGL.
 	fs_Colour = clamp(colour, 0.0, 1.0);
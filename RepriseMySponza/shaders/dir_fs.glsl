@@ -1,38 +1,18 @@
 #version 330
 
-#define MAX_INSTANCE_COUNT 64
-
-
-//----------------------Structures----------------------
-
-struct InstanceData
-{
-	mat4 mvpXform;
-	mat4 modelXform;
-	vec3 diffuse;
-	float shininess;
-	vec3 specular;
-	int isShiny;
-};
-
-struct DirectionalLight
-{
-	vec3 direction;
-	vec3 intensity;
-};
-
 
 //----------------------Uniforms----------------------
 
 layout(std140) uniform cpp_PerFrameUniforms
 {
+	mat4 cpp_ViewProjectionXform;
 	vec3 cpp_CameraPos;
 vec3 cpp_AmbientIntensity;
 };
 
-layout(std140) uniform cpp_PerModelUniforms
+layout(std140) uniform cpp_MaterialUniforms
 {
-	InstanceData cpp_Instances[MAX_INSTANCE_COUNT];
+	MaterialData cpp_Materials[MAX_MATERIAL_COUNT];
 };
 
 layout(std140) uniform cpp_DirectionalLightUniforms
@@ -40,7 +20,8 @@ layout(std140) uniform cpp_DirectionalLightUniforms
 	DirectionalLight cpp_Light;
 };
 
-uniform sampler2D cpp_Texture;
+uniform sampler2DArray cpp_Texture;
+uniform sampler2DArrayShadow cpp_CascadeShadowMaps;
 
 
 //----------------------In Variables----------------------
@@ -49,6 +30,7 @@ in vec3 vs_Position;
 in vec3 vs_Normal;
 in vec2 vs_TextureCoord;
 flat in int vs_InstanceID;
+flat in int vs_MaterialIndex;
 
 
 //----------------------Out Variables----------------------
@@ -63,14 +45,10 @@ void main(void)
 	// Creating a colour variable and beginning by adding the ambient light.
 	vec4 colour = vec4(0.0);
 
-	// Calculating the intensity of the light due to the angle it hits the fragment.
-	float angleIntensity = max(0.0, dot(cpp_Light.direction, vs_Normal));
-
-	// Calculating and returning the final colour.
-	colour += vec4(cpp_Instances[vs_InstanceID].diffuse * angleIntensity * cpp_Light.intensity, 1.0);
+	colour += ApplyDirectionalLight(cpp_Light, cpp_Materials[vs_MaterialIndex], vs_Position, vs_Normal, cpp_CascadeShadowMaps);
 
 	// Applying the texture for the fragment.
-	colour *= texture(cpp_Texture, vs_TextureCoord);
+	colour *= texture(cpp_Texture, vec3(vs_TextureCoord, cpp_Materials[vs_MaterialIndex].textureLayer));
 
 	// Passing the fragment colour to OpenGL.
 	fs_Colour = clamp(colour, 0.0, 1.0);
@@ -0,0 +1,66 @@
+#version 330
+
+
+//----------------------Uniforms----------------------
+
+layout(std140) uniform cpp_PerFrameUniforms
+{
+	mat4 cpp_ViewProjectionXform;
+	vec3 cpp_CameraPos;
+	vec3 cpp_AmbientIntensity;
+};
+
+layout(std140) uniform cpp_MaterialUniforms
+{
+	MaterialData cpp_Materials[MAX_MATERIAL_COUNT];
+};
+
+// Every light of the frame, uploaded once and looped over by each fragment.
+layout(std140) uniform cpp_LightArrayUniforms
+{
+	int cpp_DirectionalLightCount;
+	int cpp_PointLightCount;
+	int cpp_SpotLightCount;
+	DirectionalLight cpp_DirectionalLights[MAX_DIRECTIONAL_LIGHT_COUNT];
+	PointLight cpp_PointLights[MAX_LIGHT_COUNT];
+	SpotLight cpp_SpotLights[MAX_LIGHT_COUNT];
+};
+
+uniform sampler2DArray cpp_Texture;
+uniform sampler2DArrayShadow cpp_CascadeShadowMaps;
+uniform sampler2DShadow cpp_ShadowAtlas;
+
+
+//----------------------In Variables----------------------
+
+in vec3 vs_Position;
+in vec3 vs_Normal;
+in vec2 vs_TextureCoord;
+flat in int vs_InstanceID;
+flat in int vs_MaterialIndex;
+
+
+//----------------------Out Variables----------------------
+
+out vec4 fs_Colour;
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	MaterialData material = cpp_Materials[vs_MaterialIndex];
+	vec4 textureColour = texture(cpp_Texture, vec3(vs_TextureCoord, material.textureLayer));
+
+	// Clamping each light's contribution as the framebuffer did when every light was blended in its own pass.
+	vec4 colour = clamp(vec4(cpp_AmbientIntensity, 0.0) * textureColour, 0.0, 1.0);
+	for (int i = 0; i < cpp_DirectionalLightCount; i++)
+		colour += clamp(ApplyDirectionalLight(cpp_DirectionalLights[i], material, vs_Position, vs_Normal, cpp_CascadeShadowMaps) * textureColour, 0.0, 1.0);
+	for (int i = 0; i < cpp_PointLightCount; i++)
+		colour += clamp(ApplyPointLight(cpp_PointLights[i], material, vs_Position, vs_Normal, cpp_CameraPos) * textureColour, 0.0, 1.0);
+	for (int i = 0; i < cpp_SpotLightCount; i++)
+		colour += clamp(ApplySpotLight(cpp_SpotLights[i], material, vs_Position, vs_Normal, cpp_ShadowAtlas) * textureColour, 0.0, 1.0);
+
+	// Passing the fragment colour to OpenGL.
+	fs_Colour = clamp(colour, 0.0, 1.0);
+}
@@ -0,0 +1,198 @@
+// Shared by the lighting fragment shaders, prepended to each after its defines. Everything the functions read is
+// passed in, as the shader's own uniforms and inputs are declared after this.
+
+
+//----------------------Structures----------------------
+
+struct MaterialData
+{
+	vec3 diffuse;
+	float shininess;
+	vec3 specular;
+	int isShiny;
+	int textureLayer;
+};
+
+struct DirectionalLight
+{
+	vec3 direction;
+	vec3 intensity;
+	int castShadow;
+	int firstLayer;
+
+	// Take a world position to each cascade's layer of the shadow maps, sharpest first.
+	mat4 cascadeXforms[CSM_CASCADE_COUNT];
+};
+
+struct PointLight
+{
+	vec3 position;
+	float range;
+	vec3 intensity;
+};
+
+struct SpotLight
+{
+	vec3 position;
+	float range;
+	vec3 intensity;
+	float angle;
+	vec3 direction;
+	int castShadow;
+
+	// Takes a world position to the light's tile of the shadow atlas.
+	mat4 shadowXform;
+};
+
+
+//----------------------Shadow Functions----------------------
+
+// Each hardware filtered comparison blends the 2x2 texels around its coordinate, so four taps half a texel either
+// side of the fragment average a 3x3 texel footprint.
+const vec2 PCF_OFFSETS[4] = vec2[](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+
+float SamplePCF(sampler2DArrayShadow shadowMaps, vec3 shadowCoord, float layer)
+{
+	vec2 texelSize = 1.0 / vec2(textureSize(shadowMaps, 0).xy);
+	float visibility = 0.0;
+	for (int i = 0; i < 4; i++)
+		visibility += texture(shadowMaps, vec4(shadowCoord.xy + PCF_OFFSETS[i] * texelSize, layer, shadowCoord.z));
+	return visibility * 0.25;
+}
+
+float SamplePCF(sampler2DShadow shadowMap, vec3 shadowCoord)
+{
+	vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0));
+	float visibility = 0.0;
+	for (int i = 0; i < 4; i++)
+		visibility += texture(shadowMap, vec3(shadowCoord.xy + PCF_OFFSETS[i] * texelSize, shadowCoord.z));
+	return visibility * 0.25;
+}
+
+float GetShadowVisibility(DirectionalLight light, sampler2DArrayShadow cascadeShadowMaps, vec3 position)
+{
+	if (light.castShadow == 0) return 1.0;
+
+	// Using the first, and so the sharpest, cascade which covers the fragment.
+	for (int cascade = 0; cascade < CSM_CASCADE_COUNT; cascade++)
+	{
+		vec3 shadowCoord = (light.cascadeXforms[cascade] * vec4(position, 1.0)).xyz;
+		if (any(lessThan(shadowCoord, vec3(0.0))) || any(greaterThan(shadowCoord, vec3(1.0)))) continue;
+		return SamplePCF(cascadeShadowMaps, shadowCoord, float(light.firstLayer + cascade));
+	}
+
+	// Past the last cascade nothing is shadowed.
+	return 1.0;
+}
+
+float GetShadowVisibility(SpotLight light, sampler2DShadow shadowAtlas, vec3 position)
+{
+	if (light.castShadow == 0) return 1.0;
+
+	// Projecting the fragment into the light's tile of the atlas.
+	vec4 shadowCoord = light.shadowXform * vec4(position, 1.0);
+	return SamplePCF(shadowAtlas, shadowCoord.xyz / shadowCoord.w);
+}
+
+
+//----------------------Apply Light Functions----------------------
+
+vec4 ApplyDirectionalLight(DirectionalLight light, MaterialData material, vec3 position, vec3 normal,
+	sampler2DArrayShadow cascadeShadowMaps)
+{
+	// Calculating the intensity of the light due to the angle it hits the fragment.
+	float angleIntensity = max(0.0, dot(light.direction, normal));
+
+	// Calculating the final colour value, darkened by whatever blocks the light.
+	return vec4(material.diffuse * angleIntensity * light.intensity, 1.0) * GetShadowVisibility(light, cascadeShadowMaps, position);
+}
+
+vec4 ApplyPointLight(PointLight light, MaterialData material, vec3 position, vec3 normal, vec3 cameraPos)
+{
+	// Creating an empty colour variable for the light.
+	vec4 colour = vec4(0.0);
+
+	// Calculting the vector from the fragment to the light.
+	vec3 fragmentToLight = light.position - position;
+
+	// Calculating the distance between the light and the fragment.
+	float distanceToLight = length(fragmentToLight);
+
+	// Using smoothstep to calculate the intensity of the light based on its range.
+	float rangeIntensity = (1.0 - smoothstep(0, light.range, distanceToLight));
+
+	// Checking the fragment is within range of the light.
+	if (rangeIntensity > 0.0)
+	{
+		// Calculating the intensity of the light due to the angle it hits the fragment.
+		float angleIntensity = max(0.0, dot(normalize(fragmentToLight), normal));
+
+		// Using the diffuse as the base colour.
+		vec3 baseColour = material.diffuse;
+
+		// Calculating specular, which the diffuse only variant leaves out entirely.
+#if SHADER_FEATURE_SPECULAR
+		if (material.isShiny == 1 && material.shininess > 0.0)
+		{
+			// Calculating the vector from the fragment to the camera.
+			vec3 fragmentToCamera = cameraPos - position;
+
+			// Calculating the specular intensity on the fragment.
+			float specularIntensity = 0.0;
+			if (dot(normal, fragmentToLight) > 0.0)
+			{
+				vec3 resultantVector = normalize(normalize(fragmentToLight) + normalize(fragmentToCamera));
+				if (dot(normal, resultantVector) > 0)
+					specularIntensity = pow(max(dot(normal, resultantVector), 0), material.shininess);
+			}
+
+			// Adding the specular colour to the base colour.
+			baseColour += material.specular * specularIntensity;
+		}
+#endif
+
+		// Calculating the final colour value.
+		colour = vec4(baseColour * angleIntensity * light.intensity * rangeIntensity, 1.0);
+	}
+
+	// Returning the colour.
+	return colour;
+}
+
+vec4 ApplySpotLight(SpotLight light, MaterialData material, vec3 position, vec3 normal, sampler2DShadow shadowAtlas)
+{
+	// Creating an empty colour variable for the light.
+	vec4 colour = vec4(0.0);
+
+	// Normalising the forward direction of the light.
+	vec3 lightDirection = normalize(light.direction);
+
+	// Calculating the direction from the light to the fragment.
+	vec3 lightToFragment = position - light.position;
+
+	// Calculating the angle between the 'lightDirection' and 'lightToFragment' vectors.
+	float angleBetweenLightAndRay = degrees(dot(lightDirection, normalize(lightToFragment)));
+
+	// Checking if the fragment is in the light cone.
+	if (angleBetweenLightAndRay > light.angle * 0.5)
+	{
+		// Calculating the distance between the fragment and the light.
+		float distanceToLight = length(-lightToFragment);
+
+		// Using smoothstep to calculate the intensity of the light based on its range.
+		float rangeIntensity = (1.0 - smoothstep(0, light.range, distanceToLight));
+
+		// Checking the fragment is within range of the light.
+		if (rangeIntensity > 0.0)
+		{
+			// Calculating the intensity of the light due to the angle it hits the fragment.
+			float angleIntensity = max(0.0, dot(normalize(-lightToFragment), normal));
+
+			// Calculating the final colour value, darkened by whatever blocks the light.
+			colour = vec4(material.diffuse * angleIntensity * light.intensity * rangeIntensity, 1.0);
+			colour *= GetShadowVisibility(light, shadowAtlas, position);
+		}
+	}
+	// Returning the colour.
+	return colour;
+}
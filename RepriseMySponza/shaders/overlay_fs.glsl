@@ -0,0 +1,34 @@
+#version 330
+
+
+//----------------------Constants----------------------
+
+// A 3x5 bitmap font with the glyphs in the order of OVERLAY_CHARSET, each row three bits with the top row highest.
+const int FONT[45] = int[](
+	0, 31599, 11415, 29671, 29647, 23497, 31183, 31215, 29257,
+	31727, 31695, 11245, 27566, 14627, 27502, 31143, 31140, 14699,
+	23533, 29847, 4714, 23469, 18727, 24557, 27501, 11114, 27556,
+	11123, 27565, 14478, 29842, 23407, 23402, 23549, 23213, 23186,
+	29351, 1040, 2, 4772, 448, 21157, 9362, 5265, 17556);
+
+
+//----------------------In Variables----------------------
+
+in vec2 vs_FontCoord;
+flat in int vs_Glyph;
+
+
+//----------------------Out Variables----------------------
+
+out vec4 fs_Colour;
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	// Lighting the font pixels of the glyph over a translucent background which keeps the text readable.
+	ivec2 texel = ivec2(floor(vs_FontCoord));
+	bool lit = texel.x < 3 && texel.y < 5 && ((FONT[vs_Glyph] >> (14 - (texel.y * 3 + texel.x))) & 1) == 1;
+	fs_Colour = lit ? vec4(1.0, 0.9, 0.2, 1.0) : vec4(0.0, 0.0, 0.0, 0.6);
+}
@@ -0,0 +1,35 @@
+#version 330
+
+
+//----------------------Uniforms----------------------
+
+layout(std140) uniform cpp_OverlayUniforms
+{
+	vec2 cpp_ScreenSize;
+	float cpp_GlyphScale;
+
+	// The top left corner of each glyph in pixels and its index in the font.
+	vec4 cpp_Glyphs[MAX_OVERLAY_GLYPHS];
+};
+
+
+//----------------------Out Variables----------------------
+
+out vec2 vs_FontCoord;
+flat out int vs_Glyph;
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	// Generating the glyph's quad from the vertex index as a counter-clockwise strip, each cell is 3x5 font pixels
+	// plus a pixel of spacing.
+	vec2 corner = vec2(gl_VertexID >> 1, gl_VertexID & 1);
+	vec2 cellSize = vec2(4.0, 6.0);
+	vec2 pixel = cpp_Glyphs[gl_InstanceID].xy + corner * cellSize * cpp_GlyphScale;
+	gl_Position = vec4(pixel.x / cpp_ScreenSize.x * 2.0 - 1.0, 1.0 - pixel.y / cpp_ScreenSize.y * 2.0, 0.0, 1.0);
+
+	vs_FontCoord = corner * cellSize;
+	vs_Glyph = int(cpp_Glyphs[gl_InstanceID].z);
+}
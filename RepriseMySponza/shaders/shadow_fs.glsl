@@ -0,0 +1,9 @@
+#version 330
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	// Only depth is written, which OpenGL does without any help.
+}
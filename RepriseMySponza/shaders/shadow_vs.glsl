@@ -0,0 +1,35 @@
+#version 330
+
+
+//----------------------Uniforms----------------------
+
+layout(std140) uniform cpp_PerModelUniforms
+{
+	// The top three rows of each instance's model xform, as the bottom row is always (0, 0, 0, 1).
+	vec4 cpp_InstanceRows[MAX_INSTANCE_COUNT * 3];
+
+	// The material indices of four instances in each element.
+	ivec4 cpp_InstanceMaterials[MAX_INSTANCE_COUNT / 4];
+};
+
+layout(std140) uniform cpp_ShadowUniforms
+{
+	mat4 cpp_LightViewProjectionXform;
+};
+
+
+//----------------------In Variables----------------------
+
+in vec3 cpp_VertexPosition;
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	// Transforming by the rows directly, as only the position is needed.
+	int row = gl_InstanceID * 3;
+	vec4 position = vec4(cpp_VertexPosition, 1.0);
+	vec3 worldPosition = vec3(dot(cpp_InstanceRows[row], position), dot(cpp_InstanceRows[row + 1], position), dot(cpp_InstanceRows[row + 2], position));
+	gl_Position = cpp_LightViewProjectionXform * vec4(worldPosition, 1.0);
+}
@@ -0,0 +1,30 @@
+#version 330
+
+
+//----------------------Uniforms----------------------
+
+layout(std140) uniform cpp_SkyboxTriangleUniforms
+{
+	mat4 cpp_InverseViewProjectionXform;
+	vec3 cpp_CameraPos;
+};
+
+
+//----------------------Out Variables----------------------
+
+out vec3 vs_TextureCoord;
+
+
+//----------------------Main Function----------------------
+
+void main(void)
+{
+	// Generating a triangle which covers the screen from the vertex index, placed on the far plane.
+	vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2) * 2.0 - 1.0;
+	gl_Position = vec4(position, 1.0, 1.0);
+
+	// Unprojecting the corner to find the view ray, flipped to match the cube's texture coordinates.
+	vec4 farPoint = cpp_InverseViewProjectionXform * vec4(position, 1.0, 1.0);
+	vec3 direction = farPoint.xyz / farPoint.w - cpp_CameraPos;
+	vs_TextureCoord = vec3(direction.x, -direction.yz);
+}
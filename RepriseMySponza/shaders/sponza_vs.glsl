@@ -1,26 +1,22 @@
 #version 330
 
-#define MAX_INSTANCE_COUNT 64
 
+//----------------------Uniforms----------------------
 
-//----------------------Structures----------------------
-
-struct InstanceData
+layout(std140) uniform cpp_PerFrameUniforms
 {
-	mat4 mvpXform;
-	mat4 modelXform;
-	vec3 diffuse;
-	float shininess;
-	vec3 specular;
-	int isShiny;
+	mat4 cpp_ViewProjectionXform;
+	vec3 cpp_CameraPos;
+	vec3 cpp_AmbientIntensity;
 };
 
-
-//----------------------Uniforms----------------------
-
 layout(std140) uniform cpp_PerModelUniforms
 {
-	InstanceData cpp_Instances[MAX_INSTANCE_COUNT];
+	// The top three rows of each instance's model xform, as the bottom row is always (0, 0, 0, 1).
+	vec4 cpp_InstanceRows[MAX_INSTANCE_COUNT * 3];
+
+	// The material indices of four instances in each element.
+	ivec4 cpp_InstanceMaterials[MAX_INSTANCE_COUNT / 4];
 };
 
 
@@ -37,15 +33,21 @@ out vec3 vs_Position;
 out vec3 vs_Normal;
 out vec2 vs_TextureCoord;
 flat out int vs_InstanceID;
+flat out int vs_MaterialIndex;
 
 
 //----------------------Main Function----------------------
 
 void main(void)
 {
-	vs_Position = (cpp_Instances[gl_InstanceID].modelXform * vec4(cpp_VertexPosition, 1.0)).xyz;
-	vs_Normal = normalize(cpp_Instances[gl_InstanceID].modelXform * vec4(cpp_VertexNormal, 0.0)).xyz;
+	// Rebuilding the model xform from its rows, the view projection is applied here rather than per instance.
+	int row = gl_InstanceID * 3;
+	mat4 modelXform = transpose(mat4(cpp_InstanceRows[row], cpp_InstanceRows[row + 1], cpp_InstanceRows[row + 2], vec4(0.0, 0.0, 0.0, 1.0)));
+
+	vs_Position = (modelXform * vec4(cpp_VertexPosition, 1.0)).xyz;
+	vs_Normal = normalize(modelXform * vec4(cpp_VertexNormal, 0.0)).xyz;
 	vs_TextureCoord = cpp_TextureCoord;
-	gl_Position = cpp_Instances[gl_InstanceID].mvpXform * vec4(cpp_VertexPosition, 1.0);
+	gl_Position = cpp_ViewProjectionXform * vec4(vs_Position, 1.0);
 	vs_InstanceID = gl_InstanceID;
+	vs_MaterialIndex = cpp_InstanceMaterials[gl_InstanceID / 4][gl_InstanceID % 4];
 }
@@ -0,0 +1,210 @@
+#include "Benchmark.hpp"
+#include "JobSystem.hpp"
+#include "RenderStats.hpp"
+
+#include <sponza/sponza.hpp>
+#include <tygra/Window.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <thread>
+
+
+Benchmark::Benchmark(int frameCount) : mFrameCount(std::max(1, frameCount))
+{
+}
+
+
+Benchmark::~Benchmark()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+int Benchmark::Run()
+{
+	// Loading the textures with every core, each configuration then restarts the job system with its own count.
+	JobSystem::Instance().Start(std::thread::hardware_concurrency());
+	sponza::Context scene;
+	scene.setParallelFor([](size_t count, const std::function<void(size_t, size_t)>& body)
+	{
+		JobSystem::Instance().ParallelFor(count, 64, body);
+	});
+	MyView view;
+	view.setScene(&scene);
+
+	// The window only provides the GL context, every frame is rendered into an offscreen framebuffer.
+	auto window = tygra::Window::mainWindow();
+	window->setView(&view);
+	if (!window->open(BENCHMARK_WIDTH, BENCHMARK_HEIGHT, 0, true))
+	{
+		std::cerr << "Error : Unable to create an OpenGL 3.3 context for the benchmark." << std::endl;
+		return 1;
+	}
+	window->setTitle("Real-Time Graphics :: RepriseMySponza :: Benchmark");
+	CreateFramebuffer();
+
+	// Using the scene's animated camera as the scripted camera path.
+	scene.toggleCameraAnimation();
+
+	// Scaling the job system's threads to measure the parallel scene update and command building.
+	const std::vector<BenchmarkConfig> configs =
+	{
+		{ "1 thread", false, SkyboxMode::FullscreenTriangle, 1, ShadingMode::MultiPass, true },
+		{ "2 threads", false, SkyboxMode::FullscreenTriangle, 2, ShadingMode::MultiPass, true },
+		{ "4 threads", false, SkyboxMode::FullscreenTriangle, 4, ShadingMode::MultiPass, true },
+		{ "8 threads", false, SkyboxMode::FullscreenTriangle, 8, ShadingMode::MultiPass, true },
+		{ "skybox", true, SkyboxMode::FullscreenTriangle, 4, ShadingMode::MultiPass, true },
+		{ "sky cube", true, SkyboxMode::Cube, 4, ShadingMode::MultiPass, true },
+		{ "forward", false, SkyboxMode::FullscreenTriangle, 4, ShadingMode::Forward, true },
+		{ "no variant", false, SkyboxMode::FullscreenTriangle, 4, ShadingMode::MultiPass, false },
+		{ "fwd no var", false, SkyboxMode::FullscreenTriangle, 4, ShadingMode::Forward, false }
+	};
+	std::cout << "Benchmark : " << mFrameCount << " frames per configuration at "
+		<< BENCHMARK_WIDTH << "x" << BENCHMARK_HEIGHT << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+
+	// Dumping each configuration's render statistics alongside the timings, so runs can be diffed by script.
+	std::ofstream statsFile(BENCHMARK_STATS_PATH);
+	statsFile << "[\n";
+	for (size_t i = 0; i < configs.size(); i++)
+	{
+		const BenchmarkConfig& config = configs[i];
+		BenchmarkWarmup warmup;
+		const BenchmarkSummary summary = Summarise(RunConfig(view, scene, config, warmup));
+		RenderStats::Instance().WriteJson(statsFile, config.name, {
+			{ "warmup_frames", std::to_string(warmup.frames) },
+			{ "warmup_still_streaming", warmup.streaming ? "true" : "false" },
+			{ "warmup_budget_limited", warmup.budgetLimited ? "true" : "false" } });
+		if (warmup.streaming)
+			std::cerr << "Warning : '" << config.name << "' was measured while still streaming"
+				<< (warmup.budgetLimited ? ", the mesh memory budget cannot hold the scene." : ".") << std::endl;
+		statsFile << (i + 1 < configs.size() ? ",\n" : "\n");
+		std::cout << "  " << std::left << std::setw(10) << config.name << std::right
+			<< " mean " << summary.meanMs << " ms"
+			<< " | min " << summary.minMs << " ms"
+			<< " | median " << summary.medianMs << " ms"
+			<< " | p95 " << summary.p95Ms << " ms"
+			<< " | p99 " << summary.p99Ms << " ms"
+			<< " | max " << summary.maxMs << " ms" << std::endl;
+	}
+	statsFile << "]\n";
+	if (statsFile)
+		std::cout << "Render statistics written to '" << BENCHMARK_STATS_PATH << "'" << std::endl;
+	else
+		std::cerr << "Warning : Unable to write the render statistics '" << BENCHMARK_STATS_PATH << "'." << std::endl;
+
+	DeleteFramebuffer();
+	window->setView(nullptr);
+	window->close();
+	return 0;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+void Benchmark::CreateFramebuffer()
+{
+	glGenRenderbuffers(1, &mColourRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mColourRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+
+	glGenRenderbuffers(1, &mDepthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, mDepthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	MemoryTracker::Instance().Allocate(MemoryCategory::RenderTargets, BENCHMARK_RENDER_TARGET_BYTES);
+
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, mColourRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, mDepthRenderbuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("benchmark framebuffer is incomplete");
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void Benchmark::DeleteFramebuffer()
+{
+	if (mColourRenderbuffer != 0)
+		MemoryTracker::Instance().Free(MemoryCategory::RenderTargets, BENCHMARK_RENDER_TARGET_BYTES);
+	glDeleteFramebuffers(1, &mFramebuffer);
+	glDeleteRenderbuffers(1, &mColourRenderbuffer);
+	glDeleteRenderbuffers(1, &mDepthRenderbuffer);
+	mFramebuffer = mColourRenderbuffer = mDepthRenderbuffer = 0;
+}
+
+std::vector<double> Benchmark::RunConfig(MyView& view, sponza::Context& scene, const BenchmarkConfig& config, BenchmarkWarmup& warmup)
+{
+	auto window = tygra::Window::mainWindow();
+	view.SetSkyboxEnabled(config.renderSkybox);
+	view.SetSkyboxMode(config.skyboxMode);
+	view.SetShadingMode(config.shadingMode);
+	view.SetShaderVariantsEnabled(config.useShaderVariants);
+	JobSystem::Instance().Start(config.threadCount);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	view.windowViewDidReset(window, BENCHMARK_WIDTH, BENCHMARK_HEIGHT);
+
+	// Capturing each frame's snapshot on this thread so the measurement does not depend on thread scheduling.
+	SceneSnapshot snapshot;
+	view.SetSnapshot(&snapshot);
+
+	// Warming up until every texture and mesh is resident so streaming is not part of the measurement, unless the
+	// mesh budget cannot hold them all or streaming takes longer than the cap.
+	warmup = BenchmarkWarmup();
+	for (; warmup.frames < BENCHMARK_WARMUP_FRAMES || (view.IsStreaming() && !view.IsMeshBudgetLimited()
+		&& warmup.frames < BENCHMARK_MAX_WARMUP_FRAMES); warmup.frames++)
+	{
+		scene.update(0.0f);
+		SimulationPipeline::CaptureSnapshot(scene, snapshot);
+		view.windowViewRender(window);
+		glFinish();
+	}
+	warmup.streaming = view.IsStreaming();
+	warmup.budgetLimited = view.IsMeshBudgetLimited();
+
+	// Timing each frame from the scene update until the GPU has finished with it, counting only these frames.
+	RenderStats::Instance().Reset();
+	std::vector<double> frameTimes;
+	frameTimes.reserve(mFrameCount);
+	for (int frame = 0; frame < mFrameCount; frame++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		scene.update(frame * BENCHMARK_TIMESTEP);
+		SimulationPipeline::CaptureSnapshot(scene, snapshot);
+		view.windowViewRender(window);
+		glFinish();
+		frameTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	view.SetSnapshot(nullptr);
+	return frameTimes;
+}
+
+BenchmarkSummary Benchmark::Summarise(std::vector<double> frameTimes) const
+{
+	// Using nearest-rank percentiles.
+	std::sort(frameTimes.begin(), frameTimes.end());
+	const auto percentile = [&frameTimes](double p)
+	{
+		const size_t rank = (size_t)std::ceil(p * frameTimes.size());
+		return frameTimes[std::min(frameTimes.size() - 1, rank > 0 ? rank - 1 : 0)];
+	};
+
+	BenchmarkSummary summary;
+	summary.meanMs = std::accumulate(frameTimes.begin(), frameTimes.end(), 0.0) / frameTimes.size();
+	summary.minMs = frameTimes.front();
+	summary.medianMs = percentile(0.5);
+	summary.p95Ms = percentile(0.95);
+	summary.p99Ms = percentile(0.99);
+	summary.maxMs = frameTimes.back();
+	return summary;
+}
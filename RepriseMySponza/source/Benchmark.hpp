@@ -0,0 +1,77 @@
+#pragma once
+
+#include "MyView.hpp"
+
+#include <sponza/sponza_fwd.hpp>
+#include <tgl/tgl.h>
+
+#include <string>
+#include <vector>
+
+#define BENCHMARK_WIDTH 1280
+#define BENCHMARK_HEIGHT 720
+#define BENCHMARK_TIMESTEP (1.0f / 60.0f)
+#define BENCHMARK_WARMUP_FRAMES 30
+// Warming up stops here even if streaming has not finished, as a memory budget may never let it.
+#define BENCHMARK_MAX_WARMUP_FRAMES 1800
+#define BENCHMARK_DEFAULT_FRAMES 600
+#define BENCHMARK_STATS_PATH "benchmark_stats.json"
+// The RGBA8 colour and the packed depth stencil renderbuffers, 4 bytes per pixel each.
+#define BENCHMARK_RENDER_TARGET_BYTES ((size_t)BENCHMARK_WIDTH * BENCHMARK_HEIGHT * 8)
+
+
+//----------------------Structures----------------------
+
+struct BenchmarkConfig
+{
+	std::string name;
+	bool renderSkybox;
+	SkyboxMode skyboxMode;
+	int threadCount;
+	ShadingMode shadingMode;
+	bool useShaderVariants;
+};
+
+// How a configuration's warm-up ended, written with its render statistics.
+struct BenchmarkWarmup
+{
+	int frames = 0;
+	bool streaming = false;
+	bool budgetLimited = false;
+};
+
+struct BenchmarkSummary
+{
+	double meanMs;
+	double minMs;
+	double medianMs;
+	double p95Ms;
+	double p99Ms;
+	double maxMs;
+};
+
+
+//----------------------Benchmark----------------------
+
+// Renders a fixed number of frames offscreen for each configuration, stepping the scene with a fixed timestep
+// and the scene's scripted camera so every run renders exactly the same frames.
+class Benchmark
+{
+public:
+	Benchmark(int frameCount);
+	~Benchmark();
+
+	// Returns the process exit code.
+	int Run();
+
+private:
+	int mFrameCount;
+	GLuint mFramebuffer = 0;
+	GLuint mColourRenderbuffer = 0;
+	GLuint mDepthRenderbuffer = 0;
+
+	void CreateFramebuffer();
+	void DeleteFramebuffer();
+	std::vector<double> RunConfig(MyView& view, sponza::Context& scene, const BenchmarkConfig& config, BenchmarkWarmup& warmup);
+	BenchmarkSummary Summarise(std::vector<double> frameTimes) const;
+};
@@ -0,0 +1,162 @@
+#include "CascadedShadowMaps.hpp"
+#include "GLStateCache.hpp"
+#include "MemoryTracker.hpp"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+CascadedShadowMaps::CascadedShadowMaps()
+{
+}
+
+
+CascadedShadowMaps::~CascadedShadowMaps()
+{
+	Shutdown();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void CascadedShadowMaps::Init(int lightCount)
+{
+	mLightCount = lightCount;
+	mCascades.assign(lightCount * CSM_CASCADE_COUNT, ShadowCascade());
+	if (lightCount == 0) return;
+
+	// Comparing against the stored depth in the sampler, as with the spot light shadow atlas.
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mTexture);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, CSM_MAP_SIZE, CSM_MAP_SIZE, lightCount * CSM_CASCADE_COUNT,
+		0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	MemoryTracker::Instance().Allocate(MemoryCategory::ShadowMaps, GetTextureBytes());
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mTexture, 0, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("cascaded shadow map framebuffer is incomplete");
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void CascadedShadowMaps::Shutdown()
+{
+	if (mTexture != 0)
+		MemoryTracker::Instance().Free(MemoryCategory::ShadowMaps, GetTextureBytes());
+	glDeleteFramebuffers(1, &mFramebuffer);
+	glDeleteTextures(1, &mTexture);
+	mFramebuffer = mTexture = 0;
+	mCascades.clear();
+	mLightCount = 0;
+}
+
+int CascadedShadowMaps::GetLightCount() const
+{
+	return mLightCount;
+}
+
+void CascadedShadowMaps::FitCascades(int light, const glm::vec3& lightDirection, const glm::mat4& view, float fovY,
+	float aspectRatio, float nearPlane, float farPlane)
+{
+	const glm::mat4 inverseView = glm::inverse(view);
+	const float tanY = std::tan(fovY * 0.5f);
+	const float tanX = tanY * aspectRatio;
+	farPlane = std::min(farPlane, CSM_MAX_DISTANCE);
+
+	// Facing along the light's rays, with an up axis which is never parallel to them.
+	const glm::vec3 direction = glm::normalize(lightDirection);
+	const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	const glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), -direction, up);
+	const glm::mat4 inverseLightRotation = glm::inverse(lightRotation);
+
+	float sliceNear = nearPlane;
+	for (int cascade = 0; cascade < CSM_CASCADE_COUNT; cascade++)
+	{
+		// Splitting the frustum between a logarithmic and a uniform distribution, the practical split scheme.
+		const float fraction = (cascade + 1) / (float)CSM_CASCADE_COUNT;
+		const float logSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+		const float uniformSplit = nearPlane + (farPlane - nearPlane) * fraction;
+		const float sliceFar = CSM_SPLIT_LAMBDA * logSplit + (1.0f - CSM_SPLIT_LAMBDA) * uniformSplit;
+
+		// Bounding the slice's corners with a sphere whose radius is the same whichever way the camera faces.
+		glm::vec3 corners[8];
+		glm::vec3 centre(0.0f);
+		for (int i = 0; i < 8; i++)
+		{
+			const float depth = i < 4 ? sliceNear : sliceFar;
+			const glm::vec3 viewCorner((i & 1 ? 1.0f : -1.0f) * tanX * depth, (i & 2 ? 1.0f : -1.0f) * tanY * depth, -depth);
+			corners[i] = glm::vec3(inverseView * glm::vec4(viewCorner, 1.0f));
+			centre += corners[i] / 8.0f;
+		}
+		float radius = 0.0f;
+		for (const auto& corner : corners)
+			radius = std::max(radius, glm::length(corner - centre));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// Snapping the centre to the light space texel grid, so the cascade only ever moves by whole texels.
+		const float texelSize = 2.0f * radius / CSM_MAP_SIZE;
+		glm::vec3 lightCentre = glm::vec3(lightRotation * glm::vec4(centre, 1.0f));
+		lightCentre.x = std::floor(lightCentre.x / texelSize) * texelSize;
+		lightCentre.y = std::floor(lightCentre.y / texelSize) * texelSize;
+		centre = glm::vec3(inverseLightRotation * glm::vec4(lightCentre, 1.0f));
+
+		// Pulling the near plane back towards the light so casters outside the slice still shadow it.
+		const glm::vec3 eye = centre + direction * (radius + CSM_CASTER_DISTANCE);
+		ShadowCascade& current = mCascades[light * CSM_CASCADE_COUNT + cascade];
+		current.viewProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + CSM_CASTER_DISTANCE)
+			* glm::lookAt(eye, centre, up);
+		sliceNear = sliceFar;
+	}
+}
+
+ShadowCascade& CascadedShadowMaps::GetCascade(int light, int cascade)
+{
+	return mCascades[light * CSM_CASCADE_COUNT + cascade];
+}
+
+void CascadedShadowMaps::BeginCascade(int light, int cascade)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, mTexture, 0, GetLayer(light, cascade));
+	glViewport(0, 0, CSM_MAP_SIZE, CSM_MAP_SIZE);
+	GLStateCache::Instance().DepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+glm::mat4 CascadedShadowMaps::GetTextureXform(int light, int cascade) const
+{
+	// Scaling clip space [-1, 1] into [0, 1] texture space and depth.
+	glm::mat4 xform(0.5f);
+	xform[3] = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+	return xform * mCascades[light * CSM_CASCADE_COUNT + cascade].viewProjection;
+}
+
+int CascadedShadowMaps::GetLayer(int light, int cascade) const
+{
+	return light * CSM_CASCADE_COUNT + cascade;
+}
+
+GLuint CascadedShadowMaps::GetTexture() const
+{
+	return mTexture;
+}
+
+size_t CascadedShadowMaps::GetTextureBytes() const
+{
+	return (size_t)CSM_MAP_SIZE * CSM_MAP_SIZE * mLightCount * CSM_CASCADE_COUNT * 4;
+}
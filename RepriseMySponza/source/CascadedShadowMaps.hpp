@@ -0,0 +1,67 @@
+#pragma once
+
+#include <tgl/tgl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#define CSM_CASCADE_COUNT 4
+#define CSM_MAP_SIZE 1024
+#define CSM_SPLIT_LAMBDA 0.75f
+#define CSM_MAX_DISTANCE 500.0f
+#define CSM_CASTER_DISTANCE 500.0f
+
+
+//----------------------Structures----------------------
+
+struct ShadowCascade
+{
+	glm::mat4 viewProjection;
+
+	// Whether the layer holds a render of 'viewProjection', which only changes as the cascade moves a whole texel.
+	bool cached = false;
+	glm::mat4 renderedViewProjection;
+};
+
+
+//----------------------CascadedShadowMaps----------------------
+
+// The shadows of the directional lights. Each light splits the camera frustum into CSM_CASCADE_COUNT slices
+// and gives every slice a layer of a depth texture array. A slice is covered by an orthographic projection
+// around its bounding sphere, which keeps the same size as the camera turns, and moves in whole texels so
+// the shadow edges do not shimmer as the camera moves.
+class CascadedShadowMaps
+{
+public:
+	CascadedShadowMaps();
+	~CascadedShadowMaps();
+
+	void Init(int lightCount);
+	void Shutdown();
+
+	int GetLightCount() const;
+
+	// 'lightDirection' points towards the light, as in the directional light uniforms.
+	void FitCascades(int light, const glm::vec3& lightDirection, const glm::mat4& view, float fovY, float aspectRatio,
+		float nearPlane, float farPlane);
+
+	ShadowCascade& GetCascade(int light, int cascade);
+
+	// Binds the cascade's layer and clears it, leaving the viewport covering the layer.
+	void BeginCascade(int light, int cascade);
+
+	// Maps the cascade's light clip coordinates to texture coordinates and depth.
+	glm::mat4 GetTextureXform(int light, int cascade) const;
+
+	int GetLayer(int light, int cascade) const;
+	GLuint GetTexture() const;
+
+	// The size of the depth texture, counting each 24 bit depth as the 4 bytes drivers store it in.
+	size_t GetTextureBytes() const;
+
+private:
+	std::vector<ShadowCascade> mCascades;
+	int mLightCount = 0;
+	GLuint mTexture = 0;
+	GLuint mFramebuffer = 0;
+};
@@ -0,0 +1,33 @@
+#include "CommandList.hpp"
+
+
+CommandList::CommandList()
+{
+}
+
+
+CommandList::~CommandList()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void CommandList::Clear()
+{
+	mItems.clear();
+}
+
+void CommandList::Push(RenderPass pass, int program, GLuint texture, GLuint vao, float depth, DrawItem item)
+{
+	item.sortKey = RenderQueue::MakeSortKey(pass, program, texture, vao, depth);
+	item.program = program;
+	item.texture = texture;
+	item.vao = vao;
+	mItems.push_back(item);
+}
+
+const std::vector<DrawItem>& CommandList::GetItems() const
+{
+	return mItems;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "RenderQueue.hpp"
+
+#include <vector>
+
+
+//----------------------CommandList----------------------
+
+// Draws recorded by one job of the frame. The sort keys are built while recording so the lists only need
+// to be appended to the render queue, in job order, on the GL thread.
+class CommandList
+{
+public:
+	CommandList();
+	~CommandList();
+
+	void Clear();
+	void Push(RenderPass pass, int program, GLuint texture, GLuint vao, float depth, DrawItem item);
+	const std::vector<DrawItem>& GetItems() const;
+
+private:
+	std::vector<DrawItem> mItems;
+};
@@ -0,0 +1,206 @@
+#include "GLStateCache.hpp"
+
+#include <cassert>
+
+
+GLStateCache::GLStateCache()
+{
+}
+
+
+GLStateCache::~GLStateCache()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+GLStateCache& GLStateCache::Instance()
+{
+	static GLStateCache instance;
+	return instance;
+}
+
+void GLStateCache::Invalidate()
+{
+	mKnown = 0;
+	mCapabilities.clear();
+	mBuffers.clear();
+	for (auto& textures : mTextures)
+		textures.clear();
+}
+
+void GLStateCache::BeginFrame()
+{
+	mLastFrameStats = mCurrentStats;
+	mCurrentStats = GLStateStats();
+}
+
+const GLStateStats& GLStateCache::GetLastFrameStats() const
+{
+	return mLastFrameStats;
+}
+
+bool GLStateCache::SetEnabled(GLenum capability, bool enabled)
+{
+	const auto known = mCapabilities.find(capability);
+	if (!Filter(known != mCapabilities.end() && known->second == enabled)) return false;
+	if (enabled)
+		glEnable(capability);
+	else
+		glDisable(capability);
+	mCapabilities[capability] = enabled;
+	return true;
+}
+
+bool GLStateCache::Enable(GLenum capability)
+{
+	return SetEnabled(capability, true);
+}
+
+bool GLStateCache::Disable(GLenum capability)
+{
+	return SetEnabled(capability, false);
+}
+
+bool GLStateCache::DepthMask(GLboolean mask)
+{
+	if (!Filter(IsKnown(KNOWN_DEPTH_MASK) && mDepthMask == mask)) return false;
+	glDepthMask(mask);
+	mDepthMask = mask;
+	mKnown |= KNOWN_DEPTH_MASK;
+	return true;
+}
+
+bool GLStateCache::DepthFunc(GLenum func)
+{
+	if (!Filter(IsKnown(KNOWN_DEPTH_FUNC) && mDepthFunc == func)) return false;
+	glDepthFunc(func);
+	mDepthFunc = func;
+	mKnown |= KNOWN_DEPTH_FUNC;
+	return true;
+}
+
+bool GLStateCache::BlendEquation(GLenum mode)
+{
+	if (!Filter(IsKnown(KNOWN_BLEND_EQUATION) && mBlendEquation == mode)) return false;
+	glBlendEquation(mode);
+	mBlendEquation = mode;
+	mKnown |= KNOWN_BLEND_EQUATION;
+	return true;
+}
+
+bool GLStateCache::BlendFunc(GLenum sourceFactor, GLenum destinationFactor)
+{
+	if (!Filter(IsKnown(KNOWN_BLEND_FUNC) && mBlendSourceFactor == sourceFactor && mBlendDestinationFactor == destinationFactor))
+		return false;
+	glBlendFunc(sourceFactor, destinationFactor);
+	mBlendSourceFactor = sourceFactor;
+	mBlendDestinationFactor = destinationFactor;
+	mKnown |= KNOWN_BLEND_FUNC;
+	return true;
+}
+
+bool GLStateCache::PolygonOffset(GLfloat factor, GLfloat units)
+{
+	if (!Filter(IsKnown(KNOWN_POLYGON_OFFSET) && mPolygonOffsetFactor == factor && mPolygonOffsetUnits == units)) return false;
+	glPolygonOffset(factor, units);
+	mPolygonOffsetFactor = factor;
+	mPolygonOffsetUnits = units;
+	mKnown |= KNOWN_POLYGON_OFFSET;
+	return true;
+}
+
+bool GLStateCache::UseProgram(GLuint program)
+{
+	if (!Filter(IsKnown(KNOWN_PROGRAM) && mProgram == program)) return false;
+	glUseProgram(program);
+	mProgram = program;
+	mKnown |= KNOWN_PROGRAM;
+	return true;
+}
+
+GLuint GLStateCache::GetProgram() const
+{
+	return mProgram;
+}
+
+bool GLStateCache::BindVertexArray(GLuint vao)
+{
+	if (!Filter(IsKnown(KNOWN_VAO) && mVAO == vao)) return false;
+	glBindVertexArray(vao);
+	mVAO = vao;
+	mKnown |= KNOWN_VAO;
+
+	// The element buffer binding belongs to the vertex array.
+	mBuffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	return true;
+}
+
+bool GLStateCache::BindBuffer(GLenum target, GLuint buffer)
+{
+	const auto known = mBuffers.find(target);
+	if (!Filter(known != mBuffers.end() && known->second == buffer)) return false;
+	glBindBuffer(target, buffer);
+	mBuffers[target] = buffer;
+	return true;
+}
+
+bool GLStateCache::BindTexture(int unit, GLenum target, GLuint texture)
+{
+	assert(unit >= 0 && unit < GL_STATE_TEXTURE_UNITS);
+	const auto known = mTextures[unit].find(target);
+	if (!Filter(known != mTextures[unit].end() && known->second == texture)) return false;
+	ActiveTexture(unit);
+	glBindTexture(target, texture);
+	mTextures[unit][target] = texture;
+	return true;
+}
+
+void GLStateCache::ForgetTexture(GLuint texture)
+{
+	// GL reverts the bindings of a deleted object to zero, so that is what the cache now holds.
+	for (auto& textures : mTextures)
+	{
+		for (auto& binding : textures)
+			if (binding.second == texture) binding.second = 0;
+	}
+}
+
+void GLStateCache::ForgetBuffer(GLuint buffer)
+{
+	for (auto& binding : mBuffers)
+		if (binding.second == buffer) binding.second = 0;
+}
+
+void GLStateCache::ForgetVertexArray(GLuint vao)
+{
+	if (mVAO == vao) mVAO = 0;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+bool GLStateCache::Filter(bool redundant)
+{
+	if (redundant)
+	{
+		mCurrentStats.skippedCalls++;
+		return false;
+	}
+	mCurrentStats.issuedCalls++;
+	return true;
+}
+
+bool GLStateCache::IsKnown(KnownState state) const
+{
+	return (mKnown & state) != 0;
+}
+
+void GLStateCache::ActiveTexture(int unit)
+{
+	if (!Filter(IsKnown(KNOWN_ACTIVE_UNIT) && mActiveUnit == unit)) return;
+	glActiveTexture(GL_TEXTURE0 + unit);
+	mActiveUnit = unit;
+	mKnown |= KNOWN_ACTIVE_UNIT;
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <tgl/tgl.h>
+
+#include <cstdint>
+#include <unordered_map>
+
+#define GL_STATE_TEXTURE_UNITS 8
+
+
+//----------------------Structures----------------------
+
+struct GLStateStats
+{
+	int issuedCalls = 0;
+	int skippedCalls = 0;
+};
+
+
+//----------------------GLStateCache----------------------
+
+// Shadows the GL state the renderer changes every frame and drops calls which would set it to what it already
+// is. State starts unknown, so the first call always reaches GL. Code which changes tracked state without the
+// cache must be followed by Invalidate, and deleting a bound object must be reported so its name can be reused.
+class GLStateCache
+{
+public:
+	static GLStateCache& Instance();
+
+	void Invalidate();
+	void BeginFrame();
+	const GLStateStats& GetLastFrameStats() const;
+
+	// Each returns whether the call reached GL.
+	bool SetEnabled(GLenum capability, bool enabled);
+	bool Enable(GLenum capability);
+	bool Disable(GLenum capability);
+	bool DepthMask(GLboolean mask);
+	bool DepthFunc(GLenum func);
+	bool BlendEquation(GLenum mode);
+	bool BlendFunc(GLenum sourceFactor, GLenum destinationFactor);
+	bool PolygonOffset(GLfloat factor, GLfloat units);
+	bool UseProgram(GLuint program);
+	GLuint GetProgram() const;
+	bool BindVertexArray(GLuint vao);
+	bool BindBuffer(GLenum target, GLuint buffer);
+
+	// Makes 'unit' active only when the binding actually changes.
+	bool BindTexture(int unit, GLenum target, GLuint texture);
+
+	void ForgetTexture(GLuint texture);
+	void ForgetBuffer(GLuint buffer);
+	void ForgetVertexArray(GLuint vao);
+
+private:
+	// The scalar states, each of which is only trusted once the cache has set it.
+	enum KnownState : uint32_t
+	{
+		KNOWN_DEPTH_MASK = 1 << 0,
+		KNOWN_DEPTH_FUNC = 1 << 1,
+		KNOWN_BLEND_EQUATION = 1 << 2,
+		KNOWN_BLEND_FUNC = 1 << 3,
+		KNOWN_POLYGON_OFFSET = 1 << 4,
+		KNOWN_PROGRAM = 1 << 5,
+		KNOWN_VAO = 1 << 6,
+		KNOWN_ACTIVE_UNIT = 1 << 7
+	};
+
+	GLStateCache();
+	~GLStateCache();
+
+	uint32_t mKnown = 0;
+	std::unordered_map<GLenum, bool> mCapabilities;
+	GLboolean mDepthMask = GL_TRUE;
+	GLenum mDepthFunc = GL_LESS;
+	GLenum mBlendEquation = GL_FUNC_ADD;
+	GLenum mBlendSourceFactor = GL_ONE;
+	GLenum mBlendDestinationFactor = GL_ZERO;
+	GLfloat mPolygonOffsetFactor = 0.0f;
+	GLfloat mPolygonOffsetUnits = 0.0f;
+	GLuint mProgram = 0;
+	GLuint mVAO = 0;
+	int mActiveUnit = 0;
+	std::unordered_map<GLenum, GLuint> mBuffers;
+	std::unordered_map<GLenum, GLuint> mTextures[GL_STATE_TEXTURE_UNITS];
+
+	GLStateStats mCurrentStats;
+	GLStateStats mLastFrameStats;
+
+	// Counts the call and returns whether it must be issued.
+	bool Filter(bool redundant);
+	bool IsKnown(KnownState state) const;
+	void ActiveTexture(int unit);
+};
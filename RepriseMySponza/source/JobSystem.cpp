@@ -0,0 +1,268 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+
+// The index of the calling thread's deque, threads outside the pool share the first one.
+static thread_local int sThreadIndex = 0;
+
+
+JobSystem::JobSystem()
+{
+	mQueuedJobs = 0;
+	mQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+}
+
+
+JobSystem::~JobSystem()
+{
+	Stop();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+JobSystem& JobSystem::Instance()
+{
+	static JobSystem instance;
+	return instance;
+}
+
+void JobSystem::Start(int threadCount)
+{
+	Stop();
+
+	threadCount = std::max(1, threadCount);
+	mQueues.clear();
+	for (int i = 0; i < threadCount; i++)
+		mQueues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+
+	mStopping = false;
+	for (int i = 1; i < threadCount; i++)
+		mWorkers.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+}
+
+void JobSystem::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mStopping = true;
+	}
+	mSleepCondition.notify_all();
+	for (auto& worker : mWorkers)
+		worker.join();
+	mWorkers.clear();
+
+	// Running whatever the workers left behind so nobody waits on a job which will never run.
+	while (mQueuedJobs > 0)
+		Help();
+}
+
+bool JobSystem::IsStarted() const
+{
+	return !mWorkers.empty() || mQueues.size() > 1;
+}
+
+int JobSystem::GetThreadCount() const
+{
+	return mQueues.size();
+}
+
+JobHandle JobSystem::CreateJob(std::function<void()> function, const JobHandle& parent, JobPriority priority)
+{
+	JobHandle job = std::make_shared<Job>();
+	job->function = std::move(function);
+	job->parent = parent;
+	job->priority = priority;
+	job->unfinishedJobs = 1;
+	if (parent) parent->unfinishedJobs++;
+	return job;
+}
+
+void JobSystem::Run(const JobHandle& job)
+{
+	if (job->priority == JobPriority::Low)
+	{
+		std::lock_guard<std::mutex> lock(mLowPriorityQueue.mutex);
+		mLowPriorityQueue.jobs.push_back(job);
+	}
+	else
+	{
+		WorkQueue& queue = *mQueues[std::min<int>(GetThreadIndex(), mQueues.size() - 1)];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQueuedJobs++;
+	}
+	mSleepCondition.notify_one();
+}
+
+void JobSystem::RunOnWorker(const JobHandle& job)
+{
+	if (job->priority == JobPriority::Low || mQueues.size() < 2)
+	{
+		Run(job);
+		return;
+	}
+
+	// Using the last deque, which the first deque's thieves search last.
+	{
+		WorkQueue& queue = *mQueues.back();
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mQueuedJobs++;
+	}
+	mSleepCondition.notify_all();
+}
+
+void JobSystem::Wait(const JobHandle& job)
+{
+	const int threadIndex = GetThreadIndex();
+	while (!IsComplete(job))
+	{
+		// Helping with the frame's jobs, background jobs are only run here when there are no workers to run them
+		// or when the job being waited on is background work, whose children may be queued behind them.
+		JobHandle next = PopJob(threadIndex);
+		if (!next) next = StealJob(threadIndex);
+		if (!next && (mWorkers.empty() || job->priority == JobPriority::Low)) next = PopLowPriorityJob();
+		if (next)
+			Execute(next);
+		else
+			std::this_thread::yield();
+	}
+
+	// Without workers the background jobs would never progress, so one is run each time a wait finishes.
+	if (mWorkers.empty())
+	{
+		JobHandle next = PopLowPriorityJob();
+		if (next) Execute(next);
+	}
+}
+
+bool JobSystem::IsComplete(const JobHandle& job) const
+{
+	return !job || job->unfinishedJobs == 0;
+}
+
+void JobSystem::Help()
+{
+	const int threadIndex = GetThreadIndex();
+	JobHandle next = PopJob(threadIndex);
+	if (!next) next = StealJob(threadIndex);
+	if (!next) next = PopLowPriorityJob();
+	if (next)
+		Execute(next);
+	else
+		std::this_thread::yield();
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body,
+	JobPriority priority)
+{
+	if (count == 0) return;
+	grainSize = std::max<size_t>(1, grainSize);
+
+	// Running inline when the range is too small to split.
+	if (count <= grainSize || mQueues.size() == 1)
+	{
+		body(0, count);
+		return;
+	}
+
+	JobHandle root = CreateJob(nullptr, nullptr, priority);
+	for (size_t begin = 0; begin < count; begin += grainSize)
+	{
+		const size_t end = std::min(count, begin + grainSize);
+		Run(CreateJob([&body, begin, end] { body(begin, end); }, root, priority));
+	}
+	Run(root);
+	Wait(root);
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+void JobSystem::WorkerMain(int threadIndex)
+{
+	sThreadIndex = threadIndex;
+	while (true)
+	{
+		JobHandle job = PopJob(threadIndex);
+		if (!job) job = StealJob(threadIndex);
+		if (!job) job = PopLowPriorityJob();
+		if (job)
+		{
+			Execute(job);
+			continue;
+		}
+
+		// Sleeping until a job is queued, leaving once stopped and there is nothing left to do.
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mSleepCondition.wait(lock, [this] { return mStopping || mQueuedJobs > 0; });
+		if (mStopping && mQueuedJobs == 0) return;
+	}
+}
+
+int JobSystem::GetThreadIndex() const
+{
+	return sThreadIndex;
+}
+
+JobHandle JobSystem::PopJob(int threadIndex)
+{
+	// Taking the most recently pushed job, which is the most likely to still be in cache.
+	WorkQueue& queue = *mQueues[std::min<int>(threadIndex, mQueues.size() - 1)];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+	if (queue.jobs.empty()) return nullptr;
+	JobHandle job = queue.jobs.back();
+	queue.jobs.pop_back();
+	mQueuedJobs--;
+	return job;
+}
+
+JobHandle JobSystem::StealJob(int threadIndex)
+{
+	// Stealing the oldest job of another thread, starting with the next thread along.
+	for (size_t i = 1; i < mQueues.size(); i++)
+	{
+		WorkQueue& queue = *mQueues[(threadIndex + i) % mQueues.size()];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (queue.jobs.empty()) continue;
+		JobHandle job = queue.jobs.front();
+		queue.jobs.pop_front();
+		mQueuedJobs--;
+		return job;
+	}
+	return nullptr;
+}
+
+JobHandle JobSystem::PopLowPriorityJob()
+{
+	std::lock_guard<std::mutex> lock(mLowPriorityQueue.mutex);
+	if (mLowPriorityQueue.jobs.empty()) return nullptr;
+	JobHandle job = mLowPriorityQueue.jobs.front();
+	mLowPriorityQueue.jobs.pop_front();
+	mQueuedJobs--;
+	return job;
+}
+
+void JobSystem::Execute(const JobHandle& job)
+{
+	if (job->function)
+		job->function();
+	Finish(job);
+}
+
+void JobSystem::Finish(const JobHandle& job)
+{
+	// A job completes once its children have, which in turn may complete its parent.
+	if (--job->unfinishedJobs == 0 && job->parent)
+		Finish(job->parent);
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+
+//----------------------Enumerations----------------------
+
+// High priority jobs are part of the current frame and may be run by a thread waiting on another job. Low
+// priority jobs (asset loading) are only picked up by the workers, so waiting never stalls on them.
+enum class JobPriority
+{
+	High,
+	Low
+};
+
+
+//----------------------Structures----------------------
+
+struct Job
+{
+	std::function<void()> function;
+	std::shared_ptr<Job> parent;
+	JobPriority priority = JobPriority::High;
+
+	// The job itself plus its unfinished children.
+	std::atomic<int> unfinishedJobs;
+};
+
+typedef std::shared_ptr<Job> JobHandle;
+
+
+//----------------------JobSystem----------------------
+
+// A work-stealing scheduler shared by every subsystem. Each thread pushes and pops high priority jobs at the
+// back of its own deque and steals from the front of the others, while low priority jobs share a FIFO queue.
+// Threads outside the pool (the GL thread) use the first deque.
+class JobSystem
+{
+public:
+	static JobSystem& Instance();
+
+	// Runs 'threadCount' threads including the calling thread, so one less worker is created.
+	void Start(int threadCount);
+	void Stop();
+	bool IsStarted() const;
+	int GetThreadCount() const;
+
+	// A job with a parent must be created before the parent finishes, the parent then waits for it.
+	JobHandle CreateJob(std::function<void()> function, const JobHandle& parent = nullptr,
+		JobPriority priority = JobPriority::High);
+	void Run(const JobHandle& job);
+
+	// Queues a high priority job on a worker's deque rather than the caller's, for long jobs the GL thread would
+	// otherwise pop back and run inline while waiting on a short one. Falls back to Run without workers.
+	void RunOnWorker(const JobHandle& job);
+
+	// Executes other jobs until 'job' and all of its children have finished, including low priority jobs when
+	// 'job' is itself low priority.
+	void Wait(const JobHandle& job);
+	bool IsComplete(const JobHandle& job) const;
+
+	// Executes one queued job of any priority, or yields if there is none.
+	void Help();
+
+	// Calls 'body' over [0, count) in ranges of at most 'grainSize', returning once every range has run. The ranges
+	// take 'priority', so background work splitting itself stays out of reach of threads waiting on the frame.
+	void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& body,
+		JobPriority priority = JobPriority::High);
+
+private:
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<JobHandle> jobs;
+	};
+
+	JobSystem();
+	~JobSystem();
+
+	std::vector<std::unique_ptr<WorkQueue>> mQueues;
+	WorkQueue mLowPriorityQueue;
+	std::vector<std::thread> mWorkers;
+	std::atomic<int> mQueuedJobs;
+	std::mutex mSleepMutex;
+	std::condition_variable mSleepCondition;
+	bool mStopping = false;
+
+	void WorkerMain(int threadIndex);
+	int GetThreadIndex() const;
+	JobHandle PopJob(int threadIndex);
+	JobHandle StealJob(int threadIndex);
+	JobHandle PopLowPriorityJob();
+	void Execute(const JobHandle& job);
+	void Finish(const JobHandle& job);
+};
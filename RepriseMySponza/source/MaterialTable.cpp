@@ -0,0 +1,84 @@
+#include "MaterialTable.hpp"
+#include "Utils.hpp"
+
+#include <sponza/sponza.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+
+MaterialTable::MaterialTable()
+{
+}
+
+
+MaterialTable::~MaterialTable()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void MaterialTable::Init(const std::vector<sponza::Material>& materials)
+{
+	if (materials.size() > MAX_MATERIAL_COUNT)
+		throw std::runtime_error("too many materials for the material table");
+
+	// Translating the material ids to dense indices and copying the material properties.
+	mMaterialCount = materials.size();
+	mMaterialIndices.clear();
+	for (int i = 0; i < mMaterialCount; i++)
+	{
+		const auto& material = materials[i];
+		mMaterialIndices[material.getId()] = i;
+		mUniforms.materials[i].diffuse = Utils::SponzaToGLMVec3(material.getDiffuseColour());
+		mUniforms.materials[i].shininess = material.getShininess();
+		mUniforms.materials[i].specular = Utils::SponzaToGLMVec3(material.getSpecularColour());
+		mUniforms.materials[i].isShiny = material.isShiny();
+		mUniforms.materials[i].textureLayer = 0;
+	}
+}
+
+int MaterialTable::AddTextureLayer(std::string name)
+{
+	// Checking the texture is not already a layer.
+	const auto existing = std::find(mLayerNames.begin(), mLayerNames.end(), name);
+	if (existing != mLayerNames.end()) return existing - mLayerNames.begin();
+
+	mLayerNames.push_back(name);
+	return mLayerNames.size() - 1;
+}
+
+void MaterialTable::SetTextureLayer(sponza::MaterialId id, int layer)
+{
+	const auto index = mMaterialIndices.find(id);
+	if (index != mMaterialIndices.end())
+		mUniforms.materials[index->second].textureLayer = layer;
+}
+
+void MaterialTable::SetDefaultTextureLayer(int layer)
+{
+	for (int i = 0; i < mMaterialCount; i++)
+		mUniforms.materials[i].textureLayer = layer;
+}
+
+void MaterialTable::RequestTextureArray(TextureLoader& loader)
+{
+	// The layers are decoded and uploaded in the background, the loader provides a placeholder until then.
+	mTextureArray = loader.RequestTexture(TextureType::Array2D, mLayerNames);
+}
+
+int MaterialTable::GetMaterialIndex(sponza::MaterialId id) const
+{
+	const auto index = mMaterialIndices.find(id);
+	return index != mMaterialIndices.end() ? index->second : 0;
+}
+
+const MaterialUniforms& MaterialTable::GetUniforms() const
+{
+	return mUniforms;
+}
+
+TextureHandle MaterialTable::GetTextureArray() const
+{
+	return mTextureArray;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <sponza/sponza_fwd.hpp>
+#include <tgl/tgl.h>
+#include <glm/glm.hpp>
+#include "TextureLoader.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#define MAX_MATERIAL_COUNT 32
+
+
+//----------------------Structures----------------------
+
+struct MaterialData
+{
+	glm::vec3 diffuse;
+	float shininess;
+	glm::vec3 specular;
+	int isShiny;
+	int textureLayer;
+	float PADDING0[3];
+};
+
+
+//----------------------Uniform Buffer Blocks----------------------
+
+struct MaterialUniforms
+{
+	MaterialData materials[MAX_MATERIAL_COUNT];
+};
+
+
+//----------------------MaterialTable----------------------
+
+class MaterialTable
+{
+public:
+	MaterialTable();
+	~MaterialTable();
+
+	void Init(const std::vector<sponza::Material>& materials);
+
+	// Assigns an image to the next layer of the texture array, returning the layer index.
+	int AddTextureLayer(std::string name);
+	void SetTextureLayer(sponza::MaterialId id, int layer);
+	void SetDefaultTextureLayer(int layer);
+	void RequestTextureArray(TextureLoader& loader);
+
+	int GetMaterialIndex(sponza::MaterialId id) const;
+	const MaterialUniforms& GetUniforms() const;
+	TextureHandle GetTextureArray() const;
+
+private:
+	MaterialUniforms mUniforms;
+	int mMaterialCount = 0;
+	std::unordered_map<sponza::MaterialId, int> mMaterialIndices;
+
+	std::vector<std::string> mLayerNames;
+	TextureHandle mTextureArray = INVALID_TEXTURE_HANDLE;
+};
@@ -0,0 +1,134 @@
+#include "MemoryTracker.hpp"
+
+#include <iomanip>
+#include <ostream>
+
+
+//----------------------Category Names----------------------
+
+static const char* const CATEGORY_NAMES[(size_t)MemoryCategory::Count] =
+{
+	"Mesh buffers",
+	"Textures",
+	"Uniform buffers",
+	"Shadow maps",
+	"Staging buffers",
+	"Render targets",
+	"Cooked meshes",
+	"Cooked textures",
+	"Scene geometry",
+	"Scene data",
+	"Scene snapshots"
+};
+
+
+MemoryTracker::MemoryTracker()
+{
+	for (auto& counters : mCounters)
+	{
+		counters.currentBytes = 0;
+		counters.peakBytes = 0;
+		counters.allocationCount = 0;
+	}
+}
+
+
+MemoryTracker::~MemoryTracker()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+MemoryTracker& MemoryTracker::Instance()
+{
+	static MemoryTracker instance;
+	return instance;
+}
+
+void MemoryTracker::Allocate(MemoryCategory category, size_t bytes)
+{
+	Counters& counters = mCounters[(size_t)category];
+	const size_t currentBytes = counters.currentBytes += bytes;
+	counters.allocationCount++;
+
+	// Raising the high-water mark unless another thread has already raised it further.
+	size_t peakBytes = counters.peakBytes;
+	while (currentBytes > peakBytes && !counters.peakBytes.compare_exchange_weak(peakBytes, currentBytes))
+	{
+	}
+}
+
+void MemoryTracker::Free(MemoryCategory category, size_t bytes)
+{
+	mCounters[(size_t)category].currentBytes -= bytes;
+}
+
+void MemoryTracker::SetMeasuredBytes(MemoryCategory category, size_t bytes)
+{
+	Counters& counters = mCounters[(size_t)category];
+	const size_t previousBytes = counters.currentBytes.exchange(bytes);
+	if (bytes == previousBytes) return;
+	counters.allocationCount++;
+
+	size_t peakBytes = counters.peakBytes;
+	while (bytes > peakBytes && !counters.peakBytes.compare_exchange_weak(peakBytes, bytes))
+	{
+	}
+}
+
+size_t MemoryTracker::GetCurrentBytes(MemoryCategory category) const
+{
+	return mCounters[(size_t)category].currentBytes;
+}
+
+size_t MemoryTracker::GetPeakBytes(MemoryCategory category) const
+{
+	return mCounters[(size_t)category].peakBytes;
+}
+
+size_t MemoryTracker::GetAllocationCount(MemoryCategory category) const
+{
+	return mCounters[(size_t)category].allocationCount;
+}
+
+const char* MemoryTracker::GetCategoryName(MemoryCategory category)
+{
+	return CATEGORY_NAMES[(size_t)category];
+}
+
+bool MemoryTracker::IsGpuCategory(MemoryCategory category)
+{
+	return category < MemoryCategory::CookedMeshes;
+}
+
+void MemoryTracker::PrintReport(std::ostream& stream) const
+{
+	// Printing the GPU categories then the CPU ones, each group with its total. The total's peak is the sum of
+	// the categories' peaks, which may not have been reached at the same time.
+	const double megabyte = 1024.0 * 1024.0;
+	const auto flags = stream.flags();
+	const auto precision = stream.precision();
+	stream << std::fixed << std::setprecision(2);
+	stream << "Memory (MB) :" << std::setw(21) << "current" << std::setw(10) << "peak" << std::setw(14) << "allocations" << std::endl;
+	for (const bool gpu : { true, false })
+	{
+		size_t totalBytes = 0;
+		size_t totalPeakBytes = 0;
+		for (size_t i = 0; i < (size_t)MemoryCategory::Count; i++)
+		{
+			const MemoryCategory category = (MemoryCategory)i;
+			if (IsGpuCategory(category) != gpu) continue;
+			stream << "  " << (gpu ? "GPU " : "CPU ") << std::left << std::setw(18) << CATEGORY_NAMES[i] << std::right
+				<< std::setw(10) << GetCurrentBytes(category) / megabyte
+				<< std::setw(10) << GetPeakBytes(category) / megabyte
+				<< std::setw(14) << GetAllocationCount(category) << std::endl;
+			totalBytes += GetCurrentBytes(category);
+			totalPeakBytes += GetPeakBytes(category);
+		}
+		stream << "  " << (gpu ? "GPU " : "CPU ") << std::left << std::setw(18) << "total" << std::right
+			<< std::setw(10) << totalBytes / megabyte << std::setw(10) << totalPeakBytes / megabyte << std::endl;
+	}
+	stream.flags(flags);
+	stream.precision(precision);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <iosfwd>
+#include <memory>
+#include <new>
+#include <vector>
+
+
+//----------------------Enumerations----------------------
+
+// The GPU categories come first, everything from CookedMeshes on is CPU memory.
+enum class MemoryCategory
+{
+	MeshBuffers,
+	Textures,
+	UniformBuffers,
+	ShadowMaps,
+	StagingBuffers,
+	RenderTargets,
+	CookedMeshes,
+	CookedTextures,
+	SceneGeometry,
+	SceneData,
+	SceneSnapshots,
+	Count
+};
+
+
+//----------------------MemoryTracker----------------------
+
+// Byte counts per category of the memory the renderer allocates, with the high-water mark of each so that the
+// streaming budgets can be sized from a run. GL objects are counted at the size requested of the driver, which
+// may pad or compress them differently. Safe to call from any thread.
+class MemoryTracker
+{
+public:
+	static MemoryTracker& Instance();
+
+	void Allocate(MemoryCategory category, size_t bytes);
+	void Free(MemoryCategory category, size_t bytes);
+
+	// Replaces the category's byte count with a measurement, for memory owned by code which reports its size
+	// rather than allocating through a TrackedAllocator.
+	void SetMeasuredBytes(MemoryCategory category, size_t bytes);
+
+	size_t GetCurrentBytes(MemoryCategory category) const;
+	size_t GetPeakBytes(MemoryCategory category) const;
+	size_t GetAllocationCount(MemoryCategory category) const;
+	static const char* GetCategoryName(MemoryCategory category);
+	static bool IsGpuCategory(MemoryCategory category);
+
+	void PrintReport(std::ostream& stream) const;
+
+private:
+	struct Counters
+	{
+		std::atomic<size_t> currentBytes;
+		std::atomic<size_t> peakBytes;
+		std::atomic<size_t> allocationCount;
+	};
+
+	MemoryTracker();
+	~MemoryTracker();
+
+	std::array<Counters, (size_t)MemoryCategory::Count> mCounters;
+};
+
+
+//----------------------TrackedAllocator----------------------
+
+// A standard allocator which counts its containers' storage against 'Category'.
+template<typename T, MemoryCategory Category>
+class TrackedAllocator
+{
+public:
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind
+	{
+		typedef TrackedAllocator<U, Category> other;
+	};
+
+	TrackedAllocator() = default;
+
+	template<typename U>
+	TrackedAllocator(const TrackedAllocator<U, Category>&)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		T* pointer = std::allocator<T>().allocate(count);
+		MemoryTracker::Instance().Allocate(Category, count * sizeof(T));
+		return pointer;
+	}
+
+	void deallocate(T* pointer, size_t count)
+	{
+		MemoryTracker::Instance().Free(Category, count * sizeof(T));
+		std::allocator<T>().deallocate(pointer, count);
+	}
+
+	template<typename U>
+	bool operator==(const TrackedAllocator<U, Category>&) const
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const TrackedAllocator<U, Category>&) const
+	{
+		return false;
+	}
+};
+
+template<typename T, MemoryCategory Category>
+using TrackedVector = std::vector<T, TrackedAllocator<T, Category>>;
@@ -1,75 +1,162 @@
 #include "MeshData.hpp"
+#include "Utils.hpp"
+#include "GLStateCache.hpp"
 #include <sponza/sponza.hpp>
 #include <glm/glm.hpp>
 
+#include <cstring>
+#include <algorithm>
+
 
 MeshData::MeshData()
 {
 }
 
 
+MeshData::MeshData(MeshData&& other) :
+	elementCount(other.elementCount), vao(other.vao), lods(std::move(other.lods)), meshlets(std::move(other.meshlets)),
+	boundsCentre(other.boundsCentre), boundsRadius(other.boundsRadius),
+	hasBounds(other.hasBounds), vertexVBO(other.vertexVBO), elementVBO(other.elementVBO), bufferBytes(other.bufferBytes)
+{
+	// Taking ownership of the GL objects so the moved-from mesh does not delete them.
+	other.vao = other.vertexVBO = other.elementVBO = 0;
+	other.elementCount = 0;
+	other.bufferBytes = 0;
+}
+
+
 MeshData::~MeshData()
 {
-	glDeleteBuffers(1, &positionVBO);
-	glDeleteBuffers(1, &normalVBO);
-	if(textureCoordVBO!=0)
-		glDeleteBuffers(1, &textureCoordVBO);
-	glDeleteBuffers(1, &elementVBO);
-	glDeleteVertexArrays(1, &vao);
+	Release();
+}
+
+
+size_t CookedMesh::GetByteSize() const
+{
+	return vertexData.size() + elements.size() * sizeof(unsigned int);
 }
 
-void MeshData::Init(const sponza::Mesh& mesh)
+CookedMesh MeshData::Cook(const sponza::Mesh& mesh)
 {
 	// Break the mesh down into its components.
 	const auto& positions = mesh.getPositionArray();
 	const auto& normals = mesh.getNormalArray();
-	const auto& elements = mesh.getElementArray();
 	const auto& textureCoords = mesh.getTextureCoordinateArray();
 
-	// Create the VBOs.
-	GenerateBuffer(positionVBO, positions.data(), positions.size() * sizeof(glm::vec3), GL_ARRAY_BUFFER, GL_STATIC_DRAW);
-	GenerateBuffer(normalVBO, normals.data(), normals.size() * sizeof(glm::vec3), GL_ARRAY_BUFFER, GL_STATIC_DRAW);
-	GenerateBuffer(elementVBO, elements.data(), elements.size() * sizeof(unsigned int), GL_ELEMENT_ARRAY_BUFFER, GL_STATIC_DRAW);
-	if(textureCoords.size() > 0)
-		GenerateBuffer(textureCoordVBO, textureCoords.data(), textureCoords.size() * sizeof(glm::vec2), GL_ARRAY_BUFFER, GL_STATIC_DRAW);
+	// Packing the vertex arrays one after another so the mesh needs a single vertex buffer.
+	CookedMesh cooked;
+	cooked.vertexCount = positions.size();
+	cooked.hasTextureCoords = textureCoords.size() > 0;
+	const size_t positionBytes = positions.size() * sizeof(glm::vec3);
+	const size_t normalBytes = normals.size() * sizeof(glm::vec3);
+	const size_t textureCoordBytes = textureCoords.size() * sizeof(glm::vec2);
+	cooked.vertexData.resize(positionBytes + normalBytes + textureCoordBytes);
+	if (positionBytes > 0)
+		std::memcpy(cooked.vertexData.data(), positions.data(), positionBytes);
+	if (normalBytes > 0)
+		std::memcpy(cooked.vertexData.data() + positionBytes, normals.data(), normalBytes);
+	if (textureCoordBytes > 0)
+		std::memcpy(cooked.vertexData.data() + positionBytes + normalBytes, textureCoords.data(), textureCoordBytes);
+
+	// Clustering the full detail triangles into meshlets, then simplifying the mesh into its levels of detail,
+	// which all index the same vertices.
+	std::vector<unsigned int> elements = mesh.getElementArray();
+	std::vector<glm::vec3> glmPositions(positions.size());
+	for (size_t i = 0; i < positions.size(); i++)
+		glmPositions[i] = Utils::SponzaToGLMVec3(positions[i]);
+	cooked.meshlets = MeshletBuilder::Build(glmPositions, elements, elements.size());
+	cooked.lods = MeshSimplifier::BuildLodChain(glmPositions, elements);
+	cooked.elements.assign(elements.begin(), elements.end());
 
-	// Record the element count.
-	elementCount = elements.size();
+	// Bounding the mesh with the sphere around its box, so streaming can rank it before it is resident.
+	if (positions.size() > 0)
+	{
+		glm::vec3 boxMin = Utils::SponzaToGLMVec3(positions[0]);
+		glm::vec3 boxMax = boxMin;
+		for (const auto& position : positions)
+		{
+			boxMin = glm::min(boxMin, Utils::SponzaToGLMVec3(position));
+			boxMax = glm::max(boxMax, Utils::SponzaToGLMVec3(position));
+		}
+		cooked.boundsCentre = (boxMin + boxMax) * 0.5f;
+		for (const auto& position : positions)
+			cooked.boundsRadius = std::max(cooked.boundsRadius, glm::length(Utils::SponzaToGLMVec3(position) - cooked.boundsCentre));
+	}
+	return cooked;
+}
 
-	// Create the vertex array object.
+void MeshData::Allocate(const CookedMesh& mesh)
+{
+	// Create the VBOs, their contents are streamed in afterwards.
+	GLStateCache& glState = GLStateCache::Instance();
+	glGenBuffers(1, &vertexVBO);
+	glState.BindBuffer(GL_ARRAY_BUFFER, vertexVBO);
+	glBufferData(GL_ARRAY_BUFFER, mesh.vertexData.size(), nullptr, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &elementVBO);
+	glState.BindBuffer(GL_ARRAY_BUFFER, elementVBO);
+	glBufferData(GL_ARRAY_BUFFER, mesh.elements.size() * sizeof(unsigned int), nullptr, GL_STATIC_DRAW);
+	bufferBytes = mesh.GetByteSize();
+	MemoryTracker::Instance().Allocate(MemoryCategory::MeshBuffers, bufferBytes);
+
+	// Create the vertex array object, leaving it bound as the cache knows it is.
+	const size_t normalOffset = mesh.vertexCount * sizeof(glm::vec3);
+	const size_t textureCoordOffset = normalOffset * 2;
 	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
+	glState.BindVertexArray(vao);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementVBO);
+	glState.BindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementVBO);
 
-	glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+	glState.BindBuffer(GL_ARRAY_BUFFER, vertexVBO);
 	glEnableVertexAttribArray(0);
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), TGL_BUFFER_OFFSET(0));
 
-	glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), TGL_BUFFER_OFFSET(0));
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), TGL_BUFFER_OFFSET(normalOffset));
 
-	if (textureCoords.size() > 0)
+	if (mesh.hasTextureCoords)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, textureCoordVBO);
 		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), TGL_BUFFER_OFFSET(0));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), TGL_BUFFER_OFFSET(textureCoordOffset));
 	}
+}
 
-	glBindVertexArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+void MeshData::MakeResident(const CookedMesh& mesh)
+{
+	// Record the element count of the full detail level and the range of every level.
+	elementCount = mesh.lods.front().elementCount;
+	lods = mesh.lods;
+	meshlets = mesh.meshlets;
 }
 
-void MeshData::BindVAO() const
+void MeshData::Release()
 {
-	glBindVertexArray(vao);
+	GLStateCache& glState = GLStateCache::Instance();
+	glState.ForgetBuffer(vertexVBO);
+	glState.ForgetBuffer(elementVBO);
+	glState.ForgetVertexArray(vao);
+	glDeleteBuffers(1, &vertexVBO);
+	glDeleteBuffers(1, &elementVBO);
+	glDeleteVertexArrays(1, &vao);
+	MemoryTracker::Instance().Free(MemoryCategory::MeshBuffers, bufferBytes);
+	vertexVBO = elementVBO = vao = 0;
+	bufferBytes = 0;
+	elementCount = 0;
+	lods.clear();
+	meshlets.clear();
 }
 
-void MeshData::GenerateBuffer(GLuint& buffer, const void* data, GLsizeiptr size, GLenum bufferType, GLenum drawType)
+GLuint MeshData::GetVertexBuffer() const
 {
-	glGenBuffers(1, &buffer);
-	glBindBuffer(bufferType, buffer);
-	glBufferData(bufferType, size, data, drawType);
-	glBindBuffer(bufferType, 0);
-}
\ No newline at end of file
+	return vertexVBO;
+}
+
+GLuint MeshData::GetElementBuffer() const
+{
+	return elementVBO;
+}
+
+void MeshData::BindVAO() const
+{
+	GLStateCache::Instance().BindVertexArray(vao);
+}
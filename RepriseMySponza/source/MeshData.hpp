@@ -2,25 +2,71 @@
 
 #include <sponza/sponza_fwd.hpp>
 #include <tgl/tgl.h>
+#include <glm/glm.hpp>
+#include "MeshSimplifier.hpp"
+#include "MeshletBuilder.hpp"
+#include "MemoryTracker.hpp"
+
+#include <vector>
+
+
+//----------------------Structures----------------------
+
+// The GL ready arrays of a mesh, converted on a worker and streamed to the GPU in chunks. The vertex data holds
+// the positions, then the normals, then the texture coordinates when the mesh has them. The elements hold every
+// level of detail one after another, the full detail level ordered meshlet by meshlet.
+struct CookedMesh
+{
+	TrackedVector<unsigned char, MemoryCategory::CookedMeshes> vertexData;
+	TrackedVector<unsigned int, MemoryCategory::CookedMeshes> elements;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+	int vertexCount = 0;
+	bool hasTextureCoords = false;
+
+	// A bounding sphere in model space.
+	glm::vec3 boundsCentre;
+	float boundsRadius = 0.0f;
+
+	size_t GetByteSize() const;
+};
+
+
+//----------------------MeshData----------------------
 
 class MeshData
 {
 public:
 	MeshData();
+	MeshData(const MeshData&) = delete;
+	MeshData(MeshData&& other);
 	~MeshData();
 
+	// Zero until every byte of the mesh is resident, so a partially uploaded mesh is never drawn.
 	int elementCount = 0;
 	GLuint vao = 0;
+	std::vector<MeshLod> lods;
+	std::vector<Meshlet> meshlets;
+
+	// Known as soon as the mesh is converted, before any of it is resident.
+	glm::vec3 boundsCentre;
+	float boundsRadius = 0.0f;
+	bool hasBounds = false;
 
-	void Init(const sponza::Mesh& mesh);
+	static CookedMesh Cook(const sponza::Mesh& mesh);
+
+	// Creates the buffers and vertex array for 'mesh' without filling them.
+	void Allocate(const CookedMesh& mesh);
+	void MakeResident(const CookedMesh& mesh);
+
+	// Deletes the GL objects so the mesh can be streamed in again later.
+	void Release();
+	GLuint GetVertexBuffer() const;
+	GLuint GetElementBuffer() const;
 	void BindVAO() const;
 
 private:
-	GLuint positionVBO = 0;
-	GLuint normalVBO = 0;
+	GLuint vertexVBO = 0;
 	GLuint elementVBO = 0;
-	GLuint textureCoordVBO = 0;
-	
-	void GenerateBuffer(GLuint& buffer, const void* data, GLsizeiptr size, GLenum bufferType, GLenum drawType);
+	size_t bufferBytes = 0;
 };
-
@@ -0,0 +1,360 @@
+#include "MeshLoader.hpp"
+#include "RenderStats.hpp"
+#include "MemoryTracker.hpp"
+
+#include <sponza/sponza.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+
+MeshLoader::MeshLoader()
+{
+	mStopping = false;
+	mUnconvertedMeshes = 0;
+}
+
+
+MeshLoader::~MeshLoader()
+{
+	// Making sure no job outlives the loader.
+	Stop();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void MeshLoader::SetMemoryBudget(size_t bytes)
+{
+	mMemoryBudget = bytes;
+}
+
+void MeshLoader::Start()
+{
+	glGenBuffers(1, &mStagingBuffer);
+
+	// Every loading job is a child of this one, so waiting on it waits for all of them.
+	mStopping = false;
+	mLoadJobs = JobSystem::Instance().CreateJob(nullptr);
+	RunLoadJob([this] { ReadGeometry(); });
+}
+
+void MeshLoader::Stop()
+{
+	// Queued jobs see the flag and return straight away, so this only waits for jobs already running.
+	mStopping = true;
+	if (mLoadJobs)
+	{
+		JobSystem::Instance().Run(mLoadJobs);
+		while (!JobSystem::Instance().IsComplete(mLoadJobs))
+			JobSystem::Instance().Help();
+		mLoadJobs = nullptr;
+	}
+	ReleaseGeometry();
+
+	// Deleting the GL objects, only possible if the loader was started.
+	if (mStagingBuffer == 0) return;
+	mMeshes.clear();
+	mPendingMeshes.clear();
+	mRequests.clear();
+	mGeometryRead = false;
+	mResidentBytes = 0;
+	mIdle = false;
+	mBudgetLimited = false;
+	glDeleteBuffers(1, &mStagingBuffer);
+	MemoryTracker::Instance().Free(MemoryCategory::StagingBuffers, mStagingBufferBytes);
+	mStagingBuffer = 0;
+	mStagingBufferBytes = 0;
+}
+
+void MeshLoader::Update(size_t byteBudget)
+{
+	mFrameIndex++;
+
+	// Registering the meshes once the geometry has been read, the pending meshes never change after that.
+	bool allConverted;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if (mMeshes.size() < mPendingMeshes.size())
+			mMeshes.resize(mPendingMeshes.size());
+		allConverted = mGeometryRead;
+
+		// Publishing the bounds of newly converted meshes and gathering the meshes still to upload.
+		mUploadOrder.clear();
+		for (MeshHandle handle = 0; handle < mMeshes.size(); handle++)
+		{
+			const PendingMesh& pendingMesh = *mPendingMeshes[handle];
+			allConverted &= pendingMesh.converted;
+			if (!pendingMesh.converted || pendingMesh.resident) continue;
+			if (!mMeshes[handle].hasBounds)
+			{
+				mMeshes[handle].boundsCentre = pendingMesh.cooked.boundsCentre;
+				mMeshes[handle].boundsRadius = pendingMesh.cooked.boundsRadius;
+				mMeshes[handle].hasBounds = true;
+			}
+			mUploadOrder.push_back(handle);
+		}
+	}
+
+	// Streaming in visible meshes before hidden ones, nearest first.
+	if (mRequests.size() == mMeshes.size())
+	{
+		std::stable_sort(mUploadOrder.begin(), mUploadOrder.end(), [this](MeshHandle a, MeshHandle b)
+		{
+			if (mRequests[a].visible != mRequests[b].visible) return mRequests[a].visible;
+			return mRequests[a].distance < mRequests[b].distance;
+		});
+	}
+
+	size_t uploaded = 0;
+	mBudgetLimited = false;
+	for (; uploaded < mUploadOrder.size() && byteBudget > 0; uploaded++)
+	{
+		const MeshHandle handle = mUploadOrder[uploaded];
+		PendingMesh& pendingMesh = *mPendingMeshes[handle];
+		const size_t meshBytes = pendingMesh.cooked.GetByteSize();
+		if (mMemoryBudget > 0 && meshBytes > mMemoryBudget)
+		{
+			mBudgetLimited = true;
+			continue;
+		}
+		if (mMeshes[handle].vao == 0)
+		{
+			// Only a visible mesh may evict another, so hidden meshes never thrash each other out. A mesh which does
+			// not fit is skipped rather than ending the pass, as a smaller one further down may still fit.
+			const bool visible = mRequests.size() != mMeshes.size() || mRequests[handle].visible;
+			if (!MakeRoom(meshBytes, visible))
+			{
+				mBudgetLimited = true;
+				continue;
+			}
+			mMeshes[handle].Allocate(pendingMesh.cooked);
+			mResidentBytes += meshBytes;
+		}
+		UploadChunk(handle, byteBudget);
+
+		if (pendingMesh.uploadOffset == meshBytes)
+		{
+			mMeshes[handle].MakeResident(pendingMesh.cooked);
+			pendingMesh.resident = true;
+
+			// Releasing the converted arrays as soon as the mesh is on the GPU, unless it may be evicted.
+			if (mMemoryBudget == 0)
+				pendingMesh.cooked = CookedMesh();
+		}
+		else
+			break;
+	}
+
+	// Idle once nothing is left to upload, or once the budget is full of meshes which are still wanted.
+	mIdle = allConverted && (uploaded == mUploadOrder.size() || byteBudget > 0);
+}
+
+void MeshLoader::SetRequests(const std::vector<MeshRequest>& requests)
+{
+	mRequests = requests;
+	for (MeshHandle handle = 0; handle < mRequests.size() && handle < mMeshes.size(); handle++)
+		if (mRequests[handle].visible)
+			mPendingMeshes[handle]->lastVisibleFrame = mFrameIndex;
+}
+
+size_t MeshLoader::GetMeshCount() const
+{
+	return mMeshes.size();
+}
+
+const MeshData& MeshLoader::GetMesh(MeshHandle handle) const
+{
+	return mMeshes[handle];
+}
+
+sponza::MeshId MeshLoader::GetMeshId(MeshHandle handle) const
+{
+	return mPendingMeshes[handle]->id;
+}
+
+bool MeshLoader::IsIdle() const
+{
+	return mIdle;
+}
+
+bool MeshLoader::IsBudgetLimited() const
+{
+	return mBudgetLimited;
+}
+
+size_t MeshLoader::GetResidentCount() const
+{
+	size_t count = 0;
+	for (const auto& mesh : mMeshes)
+		if (mesh.elementCount > 0) count++;
+	return count;
+}
+
+size_t MeshLoader::GetResidentBytes() const
+{
+	return mResidentBytes;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+void MeshLoader::RunLoadJob(std::function<void()> function)
+{
+	// Loading is background work, so it never stalls a thread waiting on the frame's jobs.
+	JobSystem& jobSystem = JobSystem::Instance();
+	jobSystem.Run(jobSystem.CreateJob([this, function]
+	{
+		if (!mStopping) function();
+	}, mLoadJobs, JobPriority::Low));
+}
+
+void MeshLoader::ReadGeometry()
+{
+	// Reading the file on this job, with the builder's per mesh conversion spread across the job system as
+	// background work, so a thread waiting on the frame never picks it up.
+	try
+	{
+		mGeometry.reset(new sponza::GeometryBuilder([](size_t count, const std::function<void(size_t, size_t)>& body)
+		{
+			JobSystem::Instance().ParallelFor(count, MESH_CONVERT_GRAIN, body, JobPriority::Low);
+		}));
+	}
+	catch (const std::exception& exception)
+	{
+		std::cerr << "Error : Unable to read the geometry, " << exception.what() << std::endl;
+		std::lock_guard<std::mutex> lock(mMutex);
+		mGeometryRead = true;
+		return;
+	}
+
+	// Counting the builder's arrays as the scene geometry until the last mesh has been converted.
+	const auto& meshes = mGeometry->getAllMeshes();
+	mGeometryBytes = 0;
+	for (const auto& mesh : meshes)
+	{
+		mGeometryBytes += (mesh.getPositionArray().capacity() + mesh.getNormalArray().capacity()
+			+ mesh.getTangentArray().capacity()) * sizeof(sponza::Vector3)
+			+ mesh.getTextureCoordinateArray().capacity() * sizeof(sponza::Vector2)
+			+ mesh.getElementArray().size() * sizeof(unsigned int);
+	}
+	MemoryTracker::Instance().Allocate(MemoryCategory::SceneGeometry, mGeometryBytes);
+
+	// Holding one extra count until every job is queued, so the geometry is never released while still read here.
+	const size_t meshCount = meshes.size();
+	mUnconvertedMeshes = meshCount + 1;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& mesh : meshes)
+		{
+			std::unique_ptr<PendingMesh> pendingMesh(new PendingMesh());
+			pendingMesh->id = mesh.getId();
+			mPendingMeshes.push_back(std::move(pendingMesh));
+		}
+		mGeometryRead = true;
+	}
+
+	// Converting each mesh as its own job so the GL thread can upload them as they complete.
+	for (MeshHandle handle = 0; handle < meshCount; handle++)
+		RunLoadJob([this, handle] { ConvertMesh(handle); });
+	if (--mUnconvertedMeshes == 0)
+		ReleaseGeometry();
+}
+
+void MeshLoader::ReleaseGeometry()
+{
+	if (!mGeometry) return;
+	mGeometry.reset();
+	MemoryTracker::Instance().Free(MemoryCategory::SceneGeometry, mGeometryBytes);
+	mGeometryBytes = 0;
+}
+
+void MeshLoader::ConvertMesh(MeshHandle handle)
+{
+	CookedMesh cooked = MeshData::Cook(mGeometry->getAllMeshes()[handle]);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPendingMeshes[handle]->cooked = std::move(cooked);
+		mPendingMeshes[handle]->converted = true;
+	}
+
+	// The job which converts the final mesh releases the source geometry.
+	if (--mUnconvertedMeshes == 0)
+		ReleaseGeometry();
+}
+
+bool MeshLoader::MakeRoom(size_t bytes, bool evict)
+{
+	if (mMemoryBudget == 0) return true;
+
+	while (mResidentBytes + bytes > mMemoryBudget)
+	{
+		if (!evict) return false;
+
+		// Evicting the least recently visible resident mesh, never one which was visible last frame.
+		MeshHandle victim = 0;
+		uint64_t oldestFrame = mFrameIndex - 1;
+		bool found = false;
+		for (MeshHandle handle = 0; handle < mMeshes.size(); handle++)
+		{
+			const PendingMesh& pendingMesh = *mPendingMeshes[handle];
+			if (!pendingMesh.resident || pendingMesh.lastVisibleFrame >= oldestFrame) continue;
+			oldestFrame = pendingMesh.lastVisibleFrame;
+			victim = handle;
+			found = true;
+		}
+		if (!found) return false;
+		Evict(victim);
+	}
+	return true;
+}
+
+void MeshLoader::Evict(MeshHandle handle)
+{
+	PendingMesh& pendingMesh = *mPendingMeshes[handle];
+	mResidentBytes -= pendingMesh.cooked.GetByteSize();
+	mMeshes[handle].Release();
+	pendingMesh.resident = false;
+	pendingMesh.uploadOffset = 0;
+}
+
+void MeshLoader::UploadChunk(MeshHandle handle, size_t& byteBudget)
+{
+	PendingMesh& pendingMesh = *mPendingMeshes[handle];
+	const MeshData& mesh = mMeshes[handle];
+	const CookedMesh& cooked = pendingMesh.cooked;
+	const size_t vertexBytes = cooked.vertexData.size();
+	const size_t meshBytes = cooked.GetByteSize();
+	glBindBuffer(GL_COPY_READ_BUFFER, mStagingBuffer);
+
+	while (pendingMesh.uploadOffset < meshBytes && byteBudget > 0)
+	{
+		// Copying the vertex data first and then the elements, a chunk never spans the two buffers.
+		const bool vertices = pendingMesh.uploadOffset < vertexBytes;
+		const size_t regionStart = vertices ? 0 : vertexBytes;
+		const size_t regionEnd = vertices ? vertexBytes : meshBytes;
+		const size_t chunkBytes = std::min(regionEnd - pendingMesh.uploadOffset, byteBudget);
+		const unsigned char* source = vertices ? cooked.vertexData.data() + pendingMesh.uploadOffset
+			: (const unsigned char*)cooked.elements.data() + (pendingMesh.uploadOffset - vertexBytes);
+
+		glBufferData(GL_COPY_READ_BUFFER, chunkBytes, nullptr, GL_STREAM_DRAW);
+		MemoryTracker::Instance().Free(MemoryCategory::StagingBuffers, mStagingBufferBytes);
+		MemoryTracker::Instance().Allocate(MemoryCategory::StagingBuffers, chunkBytes);
+		mStagingBufferBytes = chunkBytes;
+		void* mapped = glMapBufferRange(GL_COPY_READ_BUFFER, 0, chunkBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped == nullptr) break;
+		std::memcpy(mapped, source, chunkBytes);
+		glUnmapBuffer(GL_COPY_READ_BUFFER);
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, vertices ? mesh.GetVertexBuffer() : mesh.GetElementBuffer());
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, pendingMesh.uploadOffset - regionStart, chunkBytes);
+
+		byteBudget -= chunkBytes;
+		pendingMesh.uploadOffset += chunkBytes;
+		RenderStats::Instance().Add(RenderCounter::MeshBytesUploaded, chunkBytes);
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	glBindBuffer(GL_COPY_READ_BUFFER, 0);
+}
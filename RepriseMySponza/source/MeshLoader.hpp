@@ -0,0 +1,106 @@
+#pragma once
+
+#include <sponza/sponza_fwd.hpp>
+#include <tgl/tgl.h>
+#include "MeshData.hpp"
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+
+#define MESH_CONVERT_GRAIN 16
+
+typedef uint32_t MeshHandle;
+
+
+//----------------------Structures----------------------
+
+// How much the renderer wants a mesh this frame, nearer visible meshes are streamed in first.
+struct MeshRequest
+{
+	float distance = 0.0f;
+	bool visible = true;
+};
+
+
+//----------------------MeshLoader----------------------
+
+// Reads the scene's geometry and converts every mesh as background jobs, then streams each mesh to GL through
+// a staging buffer in budgeted chunks as soon as it is converted. Meshes which are not yet resident have an
+// element count of zero, so the first frames render with whatever geometry has arrived.
+// With a memory budget the converted meshes stay in system memory and only the most wanted ones are resident,
+// the least recently visible being evicted to make room.
+class MeshLoader
+{
+public:
+	MeshLoader();
+	~MeshLoader();
+
+	// Zero keeps every mesh resident, must be set before the loader is started.
+	void SetMemoryBudget(size_t bytes);
+
+	// Queues the job which reads the geometry.
+	void Start();
+	void Stop();
+
+	// Uploads at most 'byteBudget' bytes of converted meshes, must be called on the GL thread.
+	void Update(size_t byteBudget);
+
+	// Ranks the meshes for the next update, indexed by handle.
+	void SetRequests(const std::vector<MeshRequest>& requests);
+
+	// The meshes the GL thread knows about, zero until the geometry has been read.
+	size_t GetMeshCount() const;
+	const MeshData& GetMesh(MeshHandle handle) const;
+	sponza::MeshId GetMeshId(MeshHandle handle) const;
+	bool IsIdle() const;
+
+	// Whether the last update left a wanted mesh out because the memory budget could not hold it.
+	bool IsBudgetLimited() const;
+	size_t GetResidentCount() const;
+	size_t GetResidentBytes() const;
+
+private:
+	struct PendingMesh
+	{
+		sponza::MeshId id;
+		CookedMesh cooked;
+		bool converted = false;
+		bool resident = false;
+		size_t uploadOffset = 0;
+		uint64_t lastVisibleFrame = 0;
+	};
+
+	std::unique_ptr<sponza::GeometryBuilder> mGeometry;
+	size_t mGeometryBytes = 0;
+	std::vector<std::unique_ptr<PendingMesh>> mPendingMeshes;
+	std::vector<MeshData> mMeshes;
+	mutable std::mutex mMutex;
+	JobHandle mLoadJobs;
+	std::atomic<bool> mStopping;
+	std::atomic<int> mUnconvertedMeshes;
+	bool mGeometryRead = false;
+
+	std::vector<MeshRequest> mRequests;
+	std::vector<MeshHandle> mUploadOrder;
+	size_t mMemoryBudget = 0;
+	size_t mResidentBytes = 0;
+	uint64_t mFrameIndex = 0;
+	bool mIdle = false;
+	bool mBudgetLimited = false;
+
+	GLuint mStagingBuffer = 0;
+	size_t mStagingBufferBytes = 0;
+
+	void RunLoadJob(std::function<void()> function);
+	void ReadGeometry();
+	void ReleaseGeometry();
+	void ConvertMesh(MeshHandle handle);
+	bool MakeRoom(size_t bytes, bool evict);
+	void Evict(MeshHandle handle);
+	void UploadChunk(MeshHandle handle, size_t& byteBudget);
+};
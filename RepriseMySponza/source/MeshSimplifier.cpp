@@ -0,0 +1,274 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <queue>
+#include <unordered_map>
+
+
+//----------------------Structures----------------------
+
+namespace
+{
+	// A symmetric 4x4 matrix summing squared distances to planes, stored as its upper triangle.
+	struct Quadric
+	{
+		double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+		double a11 = 0, a12 = 0, a13 = 0;
+		double a22 = 0, a23 = 0;
+		double a33 = 0;
+
+		void AddPlane(const glm::dvec3& n, double d)
+		{
+			a00 += n.x * n.x; a01 += n.x * n.y; a02 += n.x * n.z; a03 += n.x * d;
+			a11 += n.y * n.y; a12 += n.y * n.z; a13 += n.y * d;
+			a22 += n.z * n.z; a23 += n.z * d;
+			a33 += d * d;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02; a03 += q.a03;
+			a11 += q.a11; a12 += q.a12; a13 += q.a13;
+			a22 += q.a22; a23 += q.a23;
+			a33 += q.a33;
+		}
+
+		double Evaluate(const glm::vec3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			return a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+				+ a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+				+ a22 * z * z + 2 * a23 * z
+				+ a33;
+		}
+	};
+
+	// Ordered so the priority queue pops the cheapest collapse first.
+	struct Collapse
+	{
+		double cost;
+		unsigned int from;
+		unsigned int to;
+		int fromVersion;
+		int toVersion;
+
+		bool operator<(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	uint64_t EdgeKey(unsigned int a, unsigned int b)
+	{
+		return a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a;
+	}
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+std::vector<unsigned int> MeshSimplifier::Simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& elements,
+	size_t targetTriangles, float& error)
+{
+	error = 0.0f;
+	const size_t vertexCount = positions.size();
+	const size_t triangleCount = elements.size() / 3;
+
+	// Welding vertices which share a position, so seams in the other attributes do not split the surface.
+	std::vector<unsigned int> order(vertexCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&positions](unsigned int a, unsigned int b)
+	{
+		const glm::vec3& pa = positions[a];
+		const glm::vec3& pb = positions[b];
+		return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+	});
+	std::vector<unsigned int> weld(vertexCount);
+	std::vector<bool> locked(vertexCount, false);
+	for (size_t i = 0; i < vertexCount; i++)
+	{
+		const bool shared = i > 0 && positions[order[i]] == positions[order[i - 1]];
+		weld[order[i]] = shared ? weld[order[i - 1]] : order[i];
+		if (shared) locked[weld[order[i]]] = true;
+	}
+
+	// Locking the vertices of open borders, which are edges used by a single triangle.
+	std::vector<unsigned int> corners(elements);
+	std::unordered_map<uint64_t, int> edgeUses;
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int c = 0; c < 3; c++)
+			edgeUses[EdgeKey(weld[corners[t * 3 + c]], weld[corners[t * 3 + (c + 1) % 3]])]++;
+	for (const auto& edge : edgeUses)
+	{
+		if (edge.second != 1) continue;
+		locked[edge.first >> 32] = true;
+		locked[edge.first & 0xFFFFFFFF] = true;
+	}
+
+	// Summing the planes of the triangles around each vertex.
+	std::vector<Quadric> quadrics(vertexCount);
+	std::vector<std::vector<unsigned int>> vertexTriangles(vertexCount);
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const unsigned int v0 = weld[corners[t * 3]], v1 = weld[corners[t * 3 + 1]], v2 = weld[corners[t * 3 + 2]];
+		const glm::dvec3 p0(positions[v0]), p1(positions[v1]), p2(positions[v2]);
+		const glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const double length = glm::length(normal);
+		if (length > 0.0)
+		{
+			const glm::dvec3 n = normal / length;
+			Quadric quadric;
+			quadric.AddPlane(n, -glm::dot(n, p0));
+			for (unsigned int v : { v0, v1, v2 })
+				quadrics[v].Add(quadric);
+		}
+		for (unsigned int v : { v0, v1, v2 })
+			vertexTriangles[v].push_back(t);
+	}
+
+	std::vector<int> versions(vertexCount, 0);
+	std::vector<bool> collapsed(vertexCount, false);
+	std::vector<bool> removed(triangleCount, false);
+	std::priority_queue<Collapse> queue;
+	auto pushCollapse = [&](unsigned int from, unsigned int to)
+	{
+		if (locked[from] || from == to) return;
+		Quadric quadric = quadrics[from];
+		quadric.Add(quadrics[to]);
+		queue.push({ std::max(0.0, quadric.Evaluate(positions[to])), from, to, versions[from], versions[to] });
+	};
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			const unsigned int a = weld[corners[t * 3 + c]], b = weld[corners[t * 3 + (c + 1) % 3]];
+			pushCollapse(a, b);
+			pushCollapse(b, a);
+		}
+	}
+
+	size_t liveTriangles = triangleCount;
+	double maxCost = 0.0;
+	while (liveTriangles > targetTriangles && !queue.empty())
+	{
+		const Collapse collapse = queue.top();
+		queue.pop();
+		const unsigned int from = collapse.from, to = collapse.to;
+		if (collapsed[from] || collapsed[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion)
+			continue;
+
+		// Finding which copy of 'to' the triangles around 'from' should use, from a triangle sharing the edge.
+		unsigned int target = to;
+		bool sharesEdge = false;
+		for (unsigned int t : vertexTriangles[from])
+		{
+			if (removed[t]) continue;
+			for (int c = 0; c < 3; c++)
+			{
+				if (weld[corners[t * 3 + c]] != to) continue;
+				target = corners[t * 3 + c];
+				sharesEdge = true;
+			}
+		}
+		if (!sharesEdge) continue;
+
+		// Rejecting the collapse if it would flip or flatten any of the triangles which survive it.
+		bool valid = true;
+		for (unsigned int t : vertexTriangles[from])
+		{
+			if (removed[t]) continue;
+			glm::vec3 before[3], after[3];
+			bool containsTo = false;
+			for (int c = 0; c < 3; c++)
+			{
+				const unsigned int v = weld[corners[t * 3 + c]];
+				containsTo |= v == to;
+				before[c] = positions[v];
+				after[c] = v == from ? positions[to] : positions[v];
+			}
+			if (containsTo) continue;
+			const glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+			const glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+			if (glm::dot(normalBefore, normalAfter) <= 0.0f)
+			{
+				valid = false;
+				break;
+			}
+		}
+		if (!valid) continue;
+
+		// Removing the triangles on the edge and moving the rest onto 'to'.
+		for (unsigned int t : vertexTriangles[from])
+		{
+			if (removed[t]) continue;
+			bool containsTo = false;
+			for (int c = 0; c < 3; c++)
+				containsTo |= weld[corners[t * 3 + c]] == to;
+			if (containsTo)
+			{
+				removed[t] = true;
+				liveTriangles--;
+				continue;
+			}
+			for (int c = 0; c < 3; c++)
+				if (weld[corners[t * 3 + c]] == from)
+					corners[t * 3 + c] = target;
+			vertexTriangles[to].push_back(t);
+		}
+
+		quadrics[to].Add(quadrics[from]);
+		collapsed[from] = true;
+		versions[to]++;
+		maxCost = std::max(maxCost, collapse.cost);
+
+		// Requeueing the edges around 'to', whose costs have all changed.
+		for (unsigned int t : vertexTriangles[to])
+		{
+			if (removed[t]) continue;
+			for (int c = 0; c < 3; c++)
+			{
+				const unsigned int v = weld[corners[t * 3 + c]];
+				if (v == to) continue;
+				pushCollapse(to, v);
+				pushCollapse(v, to);
+			}
+		}
+	}
+
+	std::vector<unsigned int> simplified;
+	simplified.reserve(liveTriangles * 3);
+	for (size_t t = 0; t < triangleCount; t++)
+		if (!removed[t])
+			simplified.insert(simplified.end(), corners.begin() + t * 3, corners.begin() + t * 3 + 3);
+	error = (float)std::sqrt(maxCost);
+	return simplified;
+}
+
+std::vector<MeshLod> MeshSimplifier::BuildLodChain(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements)
+{
+	std::vector<MeshLod> lods(1);
+	lods[0].elementCount = elements.size();
+	if (elements.size() / 3 < MESH_LOD_MIN_TRIANGLES) return lods;
+
+	// Simplifying each level from the one before, so the errors accumulate down the chain.
+	std::vector<unsigned int> source(elements);
+	float totalError = 0.0f;
+	while (lods.size() < MESH_LOD_MAX_COUNT)
+	{
+		float error;
+		std::vector<unsigned int> simplified = Simplify(positions, source, source.size() / 6, error);
+
+		// Stopping once a level would no longer save at least a quarter of the triangles.
+		if (simplified.empty() || simplified.size() > source.size() * 3 / 4) break;
+
+		totalError += error;
+		MeshLod lod;
+		lod.firstElement = elements.size();
+		lod.elementCount = simplified.size();
+		lod.error = totalError;
+		elements.insert(elements.end(), simplified.begin(), simplified.end());
+		lods.push_back(lod);
+		source.swap(simplified);
+	}
+	return lods;
+}
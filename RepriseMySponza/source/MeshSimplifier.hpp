@@ -0,0 +1,39 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#define MESH_LOD_MAX_COUNT 5
+#define MESH_LOD_MIN_TRIANGLES 2048
+
+
+//----------------------Structures----------------------
+
+// A level of detail is a range of the mesh's element array, every level sharing the one set of vertices.
+struct MeshLod
+{
+	int firstElement = 0;
+	int elementCount = 0;
+
+	// The largest distance, in model space, any surface moved while simplifying down to this level.
+	float error = 0.0f;
+};
+
+
+//----------------------MeshSimplifier----------------------
+
+// Simplifies triangle meshes by collapsing edges in the order of their quadric error (Garland and Heckbert).
+// Vertices are only ever merged into existing vertices, so simplified levels are new element arrays over the
+// original vertex buffer. Vertices on open borders and attribute seams are never moved.
+namespace MeshSimplifier
+{
+	// Collapses edges until at most 'targetTriangles' remain or no collapse is left, returning the new elements
+	// and setting 'error' to the square root of the largest collapse cost.
+	std::vector<unsigned int> Simplify(const std::vector<glm::vec3>& positions, const std::vector<unsigned int>& elements,
+		size_t targetTriangles, float& error);
+
+	// Builds the level of detail chain of a mesh, halving the triangle count each level. The levels are appended
+	// to 'elements' after the full detail triangles, which are always the first level.
+	std::vector<MeshLod> BuildLodChain(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements);
+}
@@ -0,0 +1,135 @@
+#include "MeshletBuilder.hpp"
+#include "Utils.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+//--------------------------------Public Functions--------------------------------
+
+std::vector<Meshlet> MeshletBuilder::Build(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements, size_t elementCount)
+{
+	std::vector<Meshlet> meshlets;
+	const size_t triangleCount = elementCount / 3;
+	if (triangleCount < MESHLET_MIN_MESH_TRIANGLES) return meshlets;
+
+	// Listing the triangles around each vertex, so a meshlet can grow into its neighbours.
+	std::vector<std::vector<unsigned int>> vertexTriangles(positions.size());
+	for (size_t t = 0; t < triangleCount; t++)
+		for (int c = 0; c < 3; c++)
+			vertexTriangles[elements[t * 3 + c]].push_back(t);
+
+	std::vector<bool> used(triangleCount, false);
+	std::vector<int> meshletVertex(positions.size(), -1);
+	std::vector<unsigned int> vertices;
+	std::vector<unsigned int> triangles;
+	std::vector<unsigned int> reordered;
+	reordered.reserve(elementCount);
+	size_t nextSeed = 0;
+
+	auto newVertexCount = [&](unsigned int t)
+	{
+		int count = 0;
+		for (int c = 0; c < 3; c++)
+			count += meshletVertex[elements[t * 3 + c]] != (int)meshlets.size();
+		return count;
+	};
+
+	while (reordered.size() < triangleCount * 3)
+	{
+		vertices.clear();
+		triangles.clear();
+		while (triangles.size() < MESHLET_MAX_TRIANGLES)
+		{
+			// Choosing the neighbouring triangle which adds the fewest vertices, or the next unused one if none fit.
+			int best = -1;
+			int bestNewVertices = 4;
+			for (unsigned int v : vertices)
+			{
+				for (unsigned int t : vertexTriangles[v])
+				{
+					if (used[t]) continue;
+					const int newVertices = newVertexCount(t);
+					if (newVertices < bestNewVertices)
+					{
+						best = t;
+						bestNewVertices = newVertices;
+					}
+				}
+			}
+			if (best < 0)
+			{
+				while (nextSeed < triangleCount && used[nextSeed]) nextSeed++;
+				if (nextSeed == triangleCount) break;
+				best = nextSeed;
+				bestNewVertices = newVertexCount(best);
+			}
+			if (vertices.size() + bestNewVertices > MESHLET_MAX_VERTICES) break;
+
+			used[best] = true;
+			triangles.push_back(best);
+			for (int c = 0; c < 3; c++)
+			{
+				const unsigned int v = elements[best * 3 + c];
+				if (meshletVertex[v] == (int)meshlets.size()) continue;
+				meshletVertex[v] = meshlets.size();
+				vertices.push_back(v);
+			}
+		}
+
+		Meshlet meshlet;
+		meshlet.firstElement = reordered.size();
+		meshlet.elementCount = triangles.size() * 3;
+		for (unsigned int t : triangles)
+			reordered.insert(reordered.end(), elements.begin() + t * 3, elements.begin() + t * 3 + 3);
+
+		// Bounding the meshlet with the sphere around its box.
+		glm::vec3 boxMin = positions[vertices[0]];
+		glm::vec3 boxMax = boxMin;
+		for (unsigned int v : vertices)
+		{
+			boxMin = glm::min(boxMin, positions[v]);
+			boxMax = glm::max(boxMax, positions[v]);
+		}
+		meshlet.centre = (boxMin + boxMax) * 0.5f;
+		for (unsigned int v : vertices)
+			meshlet.radius = std::max(meshlet.radius, glm::length(positions[v] - meshlet.centre));
+
+		// Averaging the face normals into the cone axis, the cone only culls if every face is within 90 degrees of it.
+		std::vector<glm::vec3> normals;
+		glm::vec3 axis(0.0f);
+		for (unsigned int t : triangles)
+		{
+			const glm::vec3& p0 = positions[elements[t * 3]];
+			const glm::vec3 normal = glm::cross(positions[elements[t * 3 + 1]] - p0, positions[elements[t * 3 + 2]] - p0);
+			const float length = glm::length(normal);
+			if (length <= 0.0f) continue;
+			normals.push_back(normal / length);
+			axis += normals.back();
+		}
+		if (glm::length(axis) > 0.0f)
+		{
+			meshlet.coneAxis = glm::normalize(axis);
+			float minDot = 1.0f;
+			for (const auto& normal : normals)
+				minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+			meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+		}
+		meshlets.push_back(meshlet);
+	}
+
+	std::copy(reordered.begin(), reordered.end(), elements.begin());
+	return meshlets;
+}
+
+bool MeshletBuilder::IsOutsideFrustum(const Meshlet& meshlet, const glm::mat4& xform, const glm::vec4 frustumPlanes[6], float scale)
+{
+	return !Utils::IsSphereInFrustum(frustumPlanes, glm::vec3(xform * glm::vec4(meshlet.centre, 1.0f)), meshlet.radius * scale);
+}
+
+bool MeshletBuilder::IsBackFacing(const Meshlet& meshlet, const glm::vec3& cameraPos)
+{
+	// Testing the view direction to the sphere against the cone, widened by the sphere's radius.
+	const glm::vec3 toCentre = meshlet.centre - cameraPos;
+	return glm::dot(toCentre, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toCentre) + meshlet.radius;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#define MESHLET_MAX_VERTICES 64
+#define MESHLET_MAX_TRIANGLES 124
+#define MESHLET_MIN_MESH_TRIANGLES 512
+
+
+//----------------------Structures----------------------
+
+// A cluster of neighbouring triangles which is a contiguous range of the mesh's element array.
+struct Meshlet
+{
+	int firstElement = 0;
+	int elementCount = 0;
+
+	// A bounding sphere in model space.
+	glm::vec3 centre;
+	float radius = 0.0f;
+
+	// The cluster faces away from any viewer inside the cone around 'coneAxis', a cutoff of one never culls.
+	glm::vec3 coneAxis;
+	float coneCutoff = 1.0f;
+};
+
+
+//----------------------MeshletBuilder----------------------
+
+// Splits a mesh into meshlets of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES triangles, grown
+// from each seed triangle by whichever neighbour adds the fewest new vertices, and bounds each with a sphere and
+// a normal cone so hidden clusters can be skipped.
+namespace MeshletBuilder
+{
+	// Reorders the first 'elementCount' elements so each meshlet is contiguous and returns the meshlets, or
+	// nothing for meshes too small to be worth splitting.
+	std::vector<Meshlet> Build(const std::vector<glm::vec3>& positions, std::vector<unsigned int>& elements, size_t elementCount);
+
+	bool IsOutsideFrustum(const Meshlet& meshlet, const glm::mat4& xform, const glm::vec4 frustumPlanes[6], float scale);
+
+	// 'cameraPos' is in the meshlet's model space.
+	bool IsBackFacing(const Meshlet& meshlet, const glm::vec3& cameraPos);
+}
@@ -1,12 +1,15 @@
 #include "MyController.hpp"
 #include "MyView.hpp"
+#include "JobSystem.hpp"
 
 #include <sponza/sponza.hpp>
 #include <tygra/Window.hpp>
 
 #include <iostream>
 
-MyController::MyController() : camera_turn_mode_(false)
+MyController::MyController(size_t mesh_memory_budget)
+    : pending_toggle_animation_(false),
+      camera_turn_mode_(false)
 {
     camera_move_speed_[0] = 0;
     camera_move_speed_[1] = 0;
@@ -14,13 +17,25 @@ MyController::MyController() : camera_turn_mode_(false)
     camera_move_speed_[3] = 0;
     camera_rotate_speed_[0] = 0;
     camera_rotate_speed_[1] = 0;
+    // one job system is shared by the simulation, rendering and loading
+    if (!JobSystem::Instance().IsStarted())
+        JobSystem::Instance().Start(std::thread::hardware_concurrency());
     scene_ = new sponza::Context();
+    scene_->setParallelFor(
+        [](size_t count, const std::function<void(size_t, size_t)>& body)
+        {
+            JobSystem::Instance().ParallelFor(count, 64, body);
+        });
+    // the interactive demo steps once per frame, as mouse look is a velocity
+    // applied for exactly one update; fixed steps would drop or repeat it
     view_ = new MyView();
     view_->setScene(scene_);
+    view_->SetMeshMemoryBudget(mesh_memory_budget);
 }
 
 MyController::~MyController()
 {
+    pipeline_.Stop();
     delete view_;
     delete scene_;
 }
@@ -28,24 +43,49 @@ MyController::~MyController()
 void MyController::windowControlWillStart(tygra::Window * window)
 {
     window->setView(view_);
+    pipeline_.Start(scene_);
     window->setTitle("Real-Time Graphics :: RepriseMySponza");
     std::cout << "Real-Time Graphics :: RepriseMySponza" << std::endl;
 	std::cout << "*************************************\n" << std::endl;
     std::cout << "  F2 - Toggle an animated camera" << std::endl;
 	std::cout << "  F3 - Toggle skybox" << std::endl;
+	std::cout << "  F4 - Print render statistics" << std::endl;
+	std::cout << "  F5 - Print per pass CPU and GPU times" << std::endl;
+	std::cout << "  F6 - Write the profile to CSV and Chrome trace files and the render statistics to JSON" << std::endl;
+	std::cout << "  F7 - Toggle multi pass and forward shading" << std::endl;
+	std::cout << "  F8 - Toggle drawing the skybox first as a cube or last as a fullscreen triangle" << std::endl;
+	std::cout << "  F9 - Toggle per material shader variants" << std::endl;
+	std::cout << "  F10 - Toggle the render statistics overlay" << std::endl;
+	std::cout << "  F11 - Print memory use and high-water marks per category" << std::endl;
 	std::cout << std::endl;
 }
 
 void MyController::windowControlDidStop(tygra::Window * window)
 {
+    pipeline_.Stop();
     window->setView(nullptr);
 }
 
 void MyController::windowControlViewWillRender(tygra::Window * window)
 {
-    scene_->update();
+    // render the frame simulated during the previous frame's render while
+    // the next one is simulated
+    const SceneSnapshot& snapshot = pipeline_.NextFrame(
+        [this](sponza::Context& scene) { applyInput(scene); });
+    view_->SetSnapshot(&snapshot);
+}
+
+void MyController::applyInput(sponza::Context& scene)
+{
+    if (pending_toggle_animation_) {
+        scene.toggleCameraAnimation();
+        pending_toggle_animation_ = false;
+    }
+    scene.getCamera().setLinearVelocity(pending_linear_velocity_);
+    scene.getCamera().setRotationalVelocity(pending_rotational_velocity_);
     if (camera_turn_mode_) {
-        scene_->getCamera().setRotationalVelocity(sponza::Vector2(0, 0));
+        // mouse movement only turns the camera for a single step
+        pending_rotational_velocity_ = sponza::Vector2(0, 0);
     }
 }
 
@@ -59,8 +99,8 @@ void MyController::windowControlMouseMoved(tygra::Window * window,
         int dx = x - prev_x;
         int dy = y - prev_y;
         const float mouse_speed = 0.6f;
-        scene_->getCamera().setRotationalVelocity(
-            sponza::Vector2(-dx * mouse_speed, -dy * mouse_speed));
+        pending_rotational_velocity_ =
+            sponza::Vector2(-dx * mouse_speed, -dy * mouse_speed);
     }
     prev_x = x;
     prev_y = y;
@@ -112,11 +152,36 @@ void MyController::windowControlKeyboardChanged(tygra::Window * window,
     switch (key_index)
     {
     case tygra::kWindowKeyF2:
-        scene_->toggleCameraAnimation();
+        pending_toggle_animation_ = !pending_toggle_animation_;
         break;
 	case tygra::kWindowKeyF3:
 		view_->ToggleSkybox();
 		break;
+	case tygra::kWindowKeyF4:
+		view_->PrintRenderStats();
+		break;
+	case tygra::kWindowKeyF5:
+		view_->PrintProfile();
+		break;
+	case tygra::kWindowKeyF6:
+		view_->WriteProfile();
+		view_->WriteRenderStats();
+		break;
+	case tygra::kWindowKeyF7:
+		view_->ToggleShadingMode();
+		break;
+	case tygra::kWindowKeyF8:
+		view_->ToggleSkyboxMode();
+		break;
+	case tygra::kWindowKeyF9:
+		view_->ToggleShaderVariants();
+		break;
+	case tygra::kWindowKeyF10:
+		view_->ToggleStatsOverlay();
+		break;
+	case tygra::kWindowKeyF11:
+		view_->PrintMemoryReport();
+		break;
 	case tygra::kWindowKeyEsc:
 		window->close();
 		break;
@@ -166,9 +231,9 @@ void MyController::windowControlGamepadAxisMoved(tygra::Window * window,
         else {
             camera_rotate_speed_[0] = 0.f;
         }
-        scene_->getCamera().setRotationalVelocity(
+        pending_rotational_velocity_ =
             sponza::Vector2(camera_rotate_speed_[0] * rotate_speed,
-                           camera_rotate_speed_[1] * rotate_speed));
+                            camera_rotate_speed_[1] * rotate_speed);
         break;
     case tygra::kWindowGamepadAxisRightThumbY:
         if (pos < -deadzone || pos > deadzone) {
@@ -177,9 +242,9 @@ void MyController::windowControlGamepadAxisMoved(tygra::Window * window,
         else {
             camera_rotate_speed_[1] = 0.f;
         }
-        scene_->getCamera().setRotationalVelocity(
+        pending_rotational_velocity_ =
             sponza::Vector2(camera_rotate_speed_[0] * rotate_speed,
-                           camera_rotate_speed_[1] * rotate_speed));
+                            camera_rotate_speed_[1] * rotate_speed);
         break;
     }
 
@@ -200,6 +265,6 @@ void MyController::updateCameraTranslation()
         + key_speed * camera_move_speed_[1];
     const float forward_speed = key_speed * camera_move_speed_[2]
         - key_speed * camera_move_speed_[3];
-    scene_->getCamera().setLinearVelocity(
-        sponza::Vector3(sideward_speed, 0, forward_speed));
+    pending_linear_velocity_ =
+        sponza::Vector3(sideward_speed, 0, forward_speed);
 }
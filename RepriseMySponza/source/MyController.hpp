@@ -2,6 +2,7 @@
 
 #include <tygra/WindowControlDelegate.hpp>
 #include <sponza/sponza_fwd.hpp>
+#include "SimulationPipeline.hpp"
 
 class MyView;
 
@@ -9,7 +10,9 @@ class MyController : public tygra::WindowControlDelegate
 {
 public:
 
-    MyController();
+    // a non-zero budget (in bytes) streams the meshes in and out of
+    // GPU memory rather than keeping them all resident
+    explicit MyController(size_t mesh_memory_budget = 0);
 
     ~MyController();
 
@@ -48,8 +51,17 @@ private:
 
     void updateCameraTranslation();
 
+    void applyInput(sponza::Context& scene);
+
     MyView * view_;
     sponza::Context * scene_;
+    SimulationPipeline pipeline_;
+
+    // input is queued here and applied between simulation steps, as the
+    // scene is being simulated on the pipeline's worker during rendering
+    sponza::Vector3 pending_linear_velocity_;
+    sponza::Vector2 pending_rotational_velocity_;
+    bool pending_toggle_animation_;
 
     bool camera_turn_mode_;
     float camera_move_speed_[4];
@@ -7,7 +7,16 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <chrono>
+#include <thread>
 #include <cassert>
+#include <cctype>
+#include <iomanip>
+#include <sstream>
 
 
 //------------------------------------------Public Interface------------------------------------------
@@ -27,11 +36,128 @@ void MyView::setScene(const sponza::Context * sponza)
     scene_ = sponza;
 }
 
+void MyView::SetSnapshot(const SceneSnapshot* snapshot)
+{
+	mSnapshot = snapshot;
+}
+
 void MyView::ToggleSkybox()
 {
 	mRenderSkybox = !mRenderSkybox;
 }
 
+void MyView::SetSkyboxEnabled(bool enabled)
+{
+	mRenderSkybox = enabled;
+}
+
+void MyView::ToggleSkyboxMode()
+{
+	SetSkyboxMode(mSkyboxMode == SkyboxMode::Cube ? SkyboxMode::FullscreenTriangle : SkyboxMode::Cube);
+	std::cout << "Skybox : " << (mSkyboxMode == SkyboxMode::Cube ? "cube drawn first" : "fullscreen triangle drawn last") << std::endl;
+}
+
+void MyView::SetSkyboxMode(SkyboxMode mode)
+{
+	mSkyboxMode = mode;
+}
+
+void MyView::ToggleShadingMode()
+{
+	SetShadingMode(mShadingMode == ShadingMode::Forward ? ShadingMode::MultiPass : ShadingMode::Forward);
+	std::cout << "Shading : " << (mShadingMode == ShadingMode::Forward ? "forward" : "multi pass") << std::endl;
+}
+
+void MyView::SetShadingMode(ShadingMode mode)
+{
+	mShadingMode = mode;
+}
+
+void MyView::ToggleShaderVariants()
+{
+	SetShaderVariantsEnabled(!mUseShaderVariants);
+	std::cout << "Shader variants : " << (mUseShaderVariants ? "specialized per material" : "every material on the full variant") << std::endl;
+}
+
+void MyView::SetShaderVariantsEnabled(bool enabled)
+{
+	mUseShaderVariants = enabled;
+}
+
+void MyView::ToggleStatsOverlay()
+{
+	SetStatsOverlayEnabled(!mShowStatsOverlay);
+}
+
+void MyView::SetStatsOverlayEnabled(bool enabled)
+{
+	mShowStatsOverlay = enabled;
+}
+
+void MyView::SetMeshMemoryBudget(size_t bytes)
+{
+	mMeshLoader.SetMemoryBudget(bytes);
+}
+
+bool MyView::IsStreaming() const
+{
+	return !mTextureLoader.IsIdle() || !mMeshLoader.IsIdle();
+}
+
+bool MyView::IsMeshBudgetLimited() const
+{
+	return mMeshLoader.IsBudgetLimited();
+}
+
+void MyView::PrintRenderStats() const
+{
+	const auto& stats = mRenderQueue.GetLastFrameStats();
+	std::cout << "Draws : " << stats.drawCount
+		<< " | State changes : " << stats.stateChanges
+		<< " (unsorted : " << stats.naiveStateChanges << ")" << std::endl;
+	std::cout << "Triangles : " << mTriangleCount << " (full detail : " << mFullDetailTriangleCount << ")"
+		<< " | Meshlets : " << mVisibleMeshletCount << " / " << mMeshletCount << std::endl;
+	std::cout << "Resident meshes : " << mMeshLoader.GetResidentCount() << " / " << mMeshLoader.GetMeshCount()
+		<< " (" << mMeshLoader.GetResidentBytes() / (1024 * 1024) << " MB)" << std::endl;
+	std::cout << "Spot shadows rendered : " << mShadowRenderCount << " / " << mShadowTileCount
+		<< " | Cascades rendered : " << mCascadeRenderCount << " / " << mCascadedShadowMaps.GetLightCount() * CSM_CASCADE_COUNT << std::endl;
+
+	// The draws of the passes which have variants, by the variant they were drawn with.
+	std::cout << "Variant draws (point and forward) :";
+	for (int variant = 0; variant < SHADER_VARIANT_COUNT; variant++)
+		std::cout << " " << ShaderPermutations::GetVariantName(variant) << " " << mVariantDrawCounts[variant];
+	std::cout << " | Program switches : " << mProgramSwitchCount << std::endl;
+	const auto& glStats = GLStateCache::Instance().GetLastFrameStats();
+	std::cout << "GL state calls : " << glStats.issuedCalls << " issued | " << glStats.skippedCalls << " skipped as redundant" << std::endl;
+}
+
+void MyView::PrintProfile() const
+{
+	mProfiler.PrintAverages();
+}
+
+void MyView::PrintMemoryReport() const
+{
+	MemoryTracker::Instance().PrintReport(std::cout);
+}
+
+void MyView::WriteProfile() const
+{
+	// Dumping the recorded frames as a spreadsheet and as a trace which can be opened in chrome://tracing.
+	if (mProfiler.WriteCsv("profile.csv") && mProfiler.WriteChromeTrace("profile_trace.json"))
+		std::cout << "Profile written to 'profile.csv' and 'profile_trace.json'" << std::endl;
+	else
+		std::cerr << "Warning : Unable to write the profile." << std::endl;
+}
+
+void MyView::WriteRenderStats() const
+{
+	if (RenderStats::Instance().WriteJson("render_stats.json", mShadingMode == ShadingMode::Forward ? "forward" : "multi pass"))
+		std::cout << "Render statistics written to 'render_stats.json'" << std::endl;
+	else
+		std::cerr << "Warning : Unable to write the render statistics." << std::endl;
+}
+
 
 //------------------------------------------Private Functions-----------------------------------------
 
@@ -40,37 +166,94 @@ void MyView::windowViewWillStart(tygra::Window * window)
 	// Terminating the program if 'scene_' is null.
     assert(scene_ != nullptr);
 
-	// Creating the ambient pass shader program.
-	mAmbShaderProgram.Init("resource:///sponza_vs.glsl", "resource:///ambient_fs.glsl");
+	// Building every shader program up front, from the binary cache where possible.
+	BuildShaderPrograms();
+
+	// Creating the ambient pass uniform buffers.
 	mAmbShaderProgram.CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 0);
 	mAmbShaderProgram.CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 1);
+	mAmbShaderProgram.CreateUniformBuffer("cpp_MaterialUniforms", sizeof(MaterialUniforms), 12);
 
-	// Creating the direction light pass shader program.
-	mDirShaderProgram.Init("resource:///sponza_vs.glsl", "resource:///dir_fs.glsl");
+	// Creating the direction light pass uniform buffers.
 	mDirShaderProgram.CreateUniformBuffer("cpp_DirectionalLightUniforms", sizeof(DirectionalLightUniforms), 2);
 	mDirShaderProgram.CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 3);
 	mDirShaderProgram.CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 4);
+	mDirShaderProgram.CreateUniformBuffer("cpp_MaterialUniforms", sizeof(MaterialUniforms), 13);
 
-	// Creating the point light pass shader program.
-	mPointShaderProgram.Init("resource:///sponza_vs.glsl", "resource:///point_fs.glsl");
-	mPointShaderProgram.CreateUniformBuffer("cpp_PointLightUniforms", sizeof(PointLightUniforms), 5);
-	mPointShaderProgram.CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 6);
-	mPointShaderProgram.CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 7);
+	// Creating the point light pass uniform buffers, which every variant shares.
+	mPointShaderPrograms[0].CreateUniformBuffer("cpp_PointLightUniforms", sizeof(PointLightUniforms), 5);
+	mPointShaderPrograms[0].CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 6);
+	mPointShaderPrograms[0].CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 7);
+	mPointShaderPrograms[0].CreateUniformBuffer("cpp_MaterialUniforms", sizeof(MaterialUniforms), 14);
+	for (int variant = 1; variant < SHADER_VARIANT_COUNT; variant++)
+		mPointShaderPrograms[variant].ShareUniformBuffers(mPointShaderPrograms[0]);
 
-	// Creating the spot light pass shader program.
-	mSpotShaderProgram.Init("resource:///sponza_vs.glsl", "resource:///spot_fs.glsl");
+	// Creating the spot light pass uniform buffers.
 	mSpotShaderProgram.CreateUniformBuffer("cpp_SpotLightUniforms", sizeof(SpotLightUniforms), 8);
 	mSpotShaderProgram.CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 9);
 	mSpotShaderProgram.CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 10);
+	mSpotShaderProgram.CreateUniformBuffer("cpp_MaterialUniforms", sizeof(MaterialUniforms), 15);
+
+	// Creating the uniform buffers of the forward pass, which shades every light at once.
+	mForwardShaderPrograms[0].CreateUniformBuffer("cpp_LightArrayUniforms", sizeof(LightArrayUniforms), 18);
+	mForwardShaderPrograms[0].CreateUniformBuffer("cpp_PerFrameUniforms", sizeof(PerFrameUniforms), 19);
+	mForwardShaderPrograms[0].CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 20);
+	mForwardShaderPrograms[0].CreateUniformBuffer("cpp_MaterialUniforms", sizeof(MaterialUniforms), 21);
+	for (int variant = 1; variant < SHADER_VARIANT_COUNT; variant++)
+		mForwardShaderPrograms[variant].ShareUniformBuffers(mForwardShaderPrograms[0]);
+
+	// Pointing the samplers at their texture units once, as the units never change. Unit 0 holds the material
+	// textures, the shadow maps use units 1 and 2.
+	std::vector<ShaderProgram*> texturedPrograms = { &mAmbShaderProgram, &mDirShaderProgram, &mSpotShaderProgram };
+	for (int variant = 0; variant < SHADER_VARIANT_COUNT; variant++)
+	{
+		texturedPrograms.push_back(&mPointShaderPrograms[variant]);
+		texturedPrograms.push_back(&mForwardShaderPrograms[variant]);
+	}
+	for (auto* program : texturedPrograms)
+	{
+		program->Use();
+		program->SetSamplerUniform("cpp_Texture", 0);
+	}
+	mDirShaderProgram.Use();
+	mDirShaderProgram.SetSamplerUniform("cpp_CascadeShadowMaps", 1);
+	mSpotShaderProgram.Use();
+	mSpotShaderProgram.SetSamplerUniform("cpp_ShadowAtlas", 1);
+	for (auto& program : mForwardShaderPrograms)
+	{
+		program.Use();
+		program.SetSamplerUniform("cpp_CascadeShadowMaps", 1);
+		program.SetSamplerUniform("cpp_ShadowAtlas", 2);
+	}
+	GLStateCache::Instance().UseProgram(0);
+
+	// Creating the depth only pass uniform buffers and the shadow maps.
+	mShadowShaderProgram.CreateUniformBuffer("cpp_PerModelUniforms", sizeof(PerModelUniforms), 16);
+	mShadowShaderProgram.CreateUniformBuffer("cpp_ShadowUniforms", sizeof(ShadowUniforms), 17);
+	mShadowAtlas.Init();
+	mCascadedShadowMaps.Init(scene_->getAllDirectionalLights().size());
 	
-	// Load the mesh data.
-	sponza::GeometryBuilder geometryBuilder;
-	for (const auto& mesh : geometryBuilder.getAllMeshes())
-		mMeshes[mesh.getId()].Init(mesh);
-	
-	// Loading textures.
-	LoadTexture("resource:///hex.png");
-	LoadTexture("resource:///marble.png");
+	// Starting the texture loader, which decodes on the job system's workers.
+	mTextureLoader.Start();
+
+	// Building the material table and requesting its textures as the layers of a texture array. The scene's
+	// materials name no textures, so every one uses the marble layer as the original renderer did.
+	mMaterials.Init(scene_->getAllMaterials());
+	const int marbleLayer = mMaterials.AddTextureLayer("resource:///marble.png");
+	mMaterials.SetDefaultTextureLayer(marbleLayer);
+	mMaterials.RequestTextureArray(mTextureLoader);
+
+	// The materials are static so they are only uploaded once.
+	for (auto* program : { &mAmbShaderProgram, &mDirShaderProgram, &mPointShaderPrograms[0], &mSpotShaderProgram, &mForwardShaderPrograms[0] })
+		program->SetUniformBuffer("cpp_MaterialUniforms", &mMaterials.GetUniforms(), sizeof(MaterialUniforms));
+
+	// Translating the instance ids to their index in the scene snapshots.
+	const auto& instances = scene_->getAllInstances();
+	for (size_t i = 0; i < instances.size(); i++)
+		mInstanceIndices[instances[i].getId()] = i;
+
+	// Starting the mesh loader, the meshes are registered as the geometry arrives.
+	mMeshLoader.Start();
 
 
 
@@ -88,13 +271,15 @@ void MyView::windowViewWillStart(tygra::Window * window)
 
 	//------------------------------skybox------------------------------
 
-	mSkyboxShaderProgram.Init("resource:///skybox_vs.glsl", "resource:///skybox_fs.glsl");
 	mSkyboxShaderProgram.CreateUniformBuffer("cpp_SkyboxUniforms", sizeof(SkyboxUniforms), 11);
+	mSkyboxTriangleShaderProgram.CreateUniformBuffer("cpp_SkyboxTriangleUniforms", sizeof(SkyboxTriangleUniforms), 22);
+	mOverlayShaderProgram.CreateUniformBuffer("cpp_OverlayUniforms", sizeof(OverlayUniforms), 23);
 
 
 	glGenBuffers(1, &mSkyboxPositionVBO);
 	glBindBuffer(GL_ARRAY_BUFFER, mSkyboxPositionVBO);
 	glBufferData(GL_ARRAY_BUFFER, 36 * sizeof(glm::vec3), SkyBoxVertices, GL_STATIC_DRAW);
+	MemoryTracker::Instance().Allocate(MemoryCategory::MeshBuffers, 36 * sizeof(glm::vec3));
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
 	glGenVertexArrays(1, &mSkyboxVAO);
@@ -105,27 +290,14 @@ void MyView::windowViewWillStart(tygra::Window * window)
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	glGenTextures(1, &mSkyboxTexture);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, mSkyboxTexture);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	//glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-	//glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_BORDER);
-	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-	for (size_t i = 0; i < 6; ++i) {
-		const std::string url = "resource:///skybox_stormy_" + std::to_string(i) + ".png";
-		tygra::Image img = tygra::createImageFromPngFile(url);
-		if (!img.doesContainData()) {
-			throw std::runtime_error("failed to load " + url);
-		}
-		GLenum pixel_formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
-		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGBA, img.width(), img.height(), 0,
-			pixel_formats[img.componentsPerPixel()],
-			img.bytesPerComponent() == 1 ? GL_UNSIGNED_BYTE : GL_UNSIGNED_SHORT, img.pixelData());
-	}
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	// The fullscreen triangle is generated from the vertex index, but core profile still needs a vertex array bound.
+	glGenVertexArrays(1, &mSkyboxTriangleVAO);
+	glGenVertexArrays(1, &mOverlayVAO);
+
+	std::vector<std::string> skyboxFaces;
+	for (size_t i = 0; i < 6; ++i)
+		skyboxFaces.push_back("resource:///skybox_stormy_" + std::to_string(i) + ".png");
+	mSkyboxTexture = mTextureLoader.RequestTexture(TextureType::CubeMap, skyboxFaces);
 	// tell GL to wrap on the edges to neighbouring faces
 	glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
 
@@ -139,6 +311,66 @@ void MyView::windowViewWillStart(tygra::Window * window)
 }
 
 
+void MyView::BuildShaderPrograms()
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	ProgramBinaryCache programCache;
+	programCache.Load(SHADER_CACHE_PATH);
+
+	struct ProgramSource
+	{
+		ShaderProgram* program;
+		const char* vertexShaderPath;
+		const char* fragmentShaderPath;
+		uint32_t features;
+		const char* fragmentLibraryPath;
+	};
+	std::vector<ProgramSource> programs =
+	{
+		{ &mAmbShaderProgram, "resource:///sponza_vs.glsl", "resource:///ambient_fs.glsl", 0, "" },
+		{ &mDirShaderProgram, "resource:///sponza_vs.glsl", "resource:///dir_fs.glsl", 0, "resource:///lighting.glsl" },
+		{ &mSpotShaderProgram, "resource:///sponza_vs.glsl", "resource:///spot_fs.glsl", 0, "resource:///lighting.glsl" },
+		{ &mShadowShaderProgram, "resource:///shadow_vs.glsl", "resource:///shadow_fs.glsl", 0, "" },
+		{ &mSkyboxShaderProgram, "resource:///skybox_vs.glsl", "resource:///skybox_fs.glsl", 0, "" },
+		{ &mSkyboxTriangleShaderProgram, "resource:///skybox_triangle_vs.glsl", "resource:///skybox_fs.glsl", 0, "" },
+		{ &mOverlayShaderProgram, "resource:///overlay_vs.glsl", "resource:///overlay_fs.glsl", 0, "" }
+	};
+	for (uint32_t variant = 0; variant < SHADER_VARIANT_COUNT; variant++)
+	{
+		programs.push_back({ &mPointShaderPrograms[variant], "resource:///sponza_vs.glsl", "resource:///point_fs.glsl", variant, "resource:///lighting.glsl" });
+		programs.push_back({ &mForwardShaderPrograms[variant], "resource:///sponza_vs.glsl", "resource:///forward_fs.glsl", variant, "resource:///lighting.glsl" });
+	}
+
+	// Starting every program before finishing any, then finishing them in the order the driver completes them.
+	for (const auto& source : programs)
+		source.program->BeginInit(source.vertexShaderPath, source.fragmentShaderPath,
+			ShaderPermutations::MakeDefines(source.features), &programCache, source.fragmentLibraryPath);
+	std::vector<ShaderProgram*> pending;
+	for (const auto& source : programs)
+		pending.push_back(source.program);
+	int cachedCount = 0;
+	while (!pending.empty())
+	{
+		auto ready = std::find_if(pending.begin(), pending.end(), [](const ShaderProgram* program) { return program->IsReady(); });
+		if (ready == pending.end())
+		{
+			std::this_thread::yield();
+			continue;
+		}
+		(*ready)->FinishInit();
+		cachedCount += (*ready)->WasCached() ? 1 : 0;
+		pending.erase(ready);
+	}
+
+	if (ProgramBinaryCache::IsSupported() && !programCache.Save(SHADER_CACHE_PATH))
+		std::cerr << "Warning : Unable to write the shader cache '" << SHADER_CACHE_PATH << "'." << std::endl;
+
+	const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	std::cout << "Shaders : " << programs.size() << " programs ready in " << elapsedMs << " ms ("
+		<< cachedCount << " from the binary cache" << (ShaderProgram::HasParallelCompile() ? ", compiled in parallel" : "") << ")" << std::endl;
+}
+
+
 void MyView::windowViewDidReset(tygra::Window * window,
                                 int width,
                                 int height)
@@ -153,25 +385,50 @@ void MyView::windowViewDidReset(tygra::Window * window,
 
 void MyView::windowViewDidStop(tygra::Window * window)
 {
-	// Deleting the textures.
-	for (const auto& tex : mTextures)
-	{
-		glDeleteTextures(1, &tex.second);
-	}
+	// Reporting before anything is released, so the report shows what was in use at exit beside the peaks.
+	PrintMemoryReport();
+
+	// Stopping the loaders, which deletes the textures and meshes.
+	mTextureLoader.Stop();
+	mMeshLoader.Stop();
+	mMeshIds.clear();
+	mMeshInstanceIndices.clear();
+	mMeshInstanceMaterials.clear();
+	mMeshRequests.clear();
+	mShadowAtlas.Shutdown();
+	mCascadedShadowMaps.Shutdown();
+	mSpotShadowStates.clear();
+	mPreviousInstanceXforms.clear();
+	mProfiler.Shutdown();
 
 	glDeleteBuffers(1, &mSkyboxPositionVBO);
-	glDeleteTextures(1, &mSkyboxTexture);
+	MemoryTracker::Instance().Free(MemoryCategory::MeshBuffers, 36 * sizeof(glm::vec3));
 	glDeleteVertexArrays(1, &mSkyboxVAO);
+	glDeleteVertexArrays(1, &mSkyboxTriangleVAO);
+	glDeleteVertexArrays(1, &mOverlayVAO);
 }
 
 
 void MyView::windowViewRender(tygra::Window * window)
 {
-	// Terminating the program if 'scene_' is null.
-	assert(scene_ != nullptr);
+	// Terminating the program if there is no snapshot of the scene to render.
+	assert(mSnapshot != nullptr);
+	const SceneSnapshot& snapshot = *mSnapshot;
+
+	mProfiler.BeginFrame();
+	GLStateCache& glState = GLStateCache::Instance();
+	glState.BeginFrame();
+
+	// Streaming any decoded textures and converted meshes to the GPU within the frame's upload budgets.
+	mTextureLoader.Update(TEXTURE_UPLOAD_BUDGET);
+	mMeshLoader.Update(MESH_UPLOAD_BUDGET);
+	RegisterMeshes();
+
+	// The uploads bind textures and buffers directly, so the rest of the frame starts from unknown state.
+	glState.Invalidate();
 
 	// Clearing the contents of the buffers from the previous frame.
-	glDepthMask(GL_TRUE);
+	glState.DepthMask(GL_TRUE);
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 	// Calculating the aspect ratio.
@@ -183,210 +440,809 @@ void MyView::windowViewRender(tygra::Window * window)
 	PerFrameUniforms perFrameUniforms;
 
 	// Getting the camera data for the frame.
-	sponza::Camera camera = scene_->getCamera();
+	const sponza::Camera& camera = snapshot.camera;
 	auto camDir = Utils::SponzaToGLMVec3(camera.getDirection());
-	auto upDir = Utils::SponzaToGLMVec3(scene_->getUpDirection());
+	auto upDir = snapshot.upDirection;
 
 	// Populating the per frame uniform buffer.
 	perFrameUniforms.cameraPos = Utils::SponzaToGLMVec3(camera.getPosition());
-	perFrameUniforms.ambientIntensity = Utils::SponzaToGLMVec3(scene_->getAmbientLightIntensity());
+	perFrameUniforms.ambientIntensity = snapshot.ambientIntensity;
 
 	// Calculating the projection and view matrices.
 	glm::mat4 projection = glm::perspective(glm::radians(camera.getVerticalFieldOfViewInDegrees()),
 		aspectRatio, camera.getNearPlaneDistance(),
 		camera.getFarPlaneDistance());	
 	glm::mat4 view = glm::lookAt(perFrameUniforms.cameraPos, perFrameUniforms.cameraPos + camDir, upDir);
+	perFrameUniforms.viewProjectionXform = projection * view;
 
 
 
 
 	// --------------------Skybox--------------------
 
-	if (mRenderSkybox)
+	// The cube is drawn behind everything before the geometry, the triangle waits for the depth buffer.
+	if (mRenderSkybox && mSkyboxMode == SkyboxMode::Cube)
+		DrawSkybox(projection * view, perFrameUniforms.cameraPos);
+
+
+	// --------------------Populating the per model uniform buffers and the render queue--------------------
+
+	FrameView frameView;
 	{
-		mSkyboxShaderProgram.Use();
-		glDisable(GL_DEPTH_TEST);
-		glDisable(GL_BLEND);
+		ProfileScope profileScope(mProfiler, "Queue");
+		frameView.viewProjection = projection * view;
+		frameView.cameraPos = perFrameUniforms.cameraPos;
+		frameView.cameraDir = camDir;
+		frameView.farPlane = camera.getFarPlaneDistance();
+		frameView.texture = mTextureLoader.GetTexture(mMaterials.GetTextureArray());
+		Utils::ExtractFrustumPlanes(frameView.viewProjection, frameView.frustumPlanes);
+
+		// Scaling a model space error at unit distance to pixels on screen.
+		frameView.lodScale = projection[1][1] * viewportSize[3] * 0.5f;
+
+		// Splitting the meshes into ranges which record into their own command lists, the final job builds the light uniforms.
+		const int meshJobCount = JobSystem::Instance().GetThreadCount() * MESH_JOBS_PER_THREAD;
+		mFrameJobs.resize(meshJobCount);
+		JobSystem::Instance().ParallelFor(meshJobCount + 1, 1, [&](size_t begin, size_t end)
+		{
+			for (int job = (int)begin; job < (int)end; job++)
+			{
+				if (job < meshJobCount)
+					BuildMeshCommands(snapshot, frameView, job, meshJobCount);
+				else
+					BuildLightUniforms(snapshot);
+			}
+		});
+
+		// Ranking the meshes for streaming by what the jobs saw this frame.
+		mMeshLoader.SetRequests(mMeshRequests);
+		mTriangleCount = mFullDetailTriangleCount = mMeshletCount = mVisibleMeshletCount = 0;
+		mProgramSwitchCount = 0;
+		std::fill(std::begin(mVariantDrawCounts), std::end(mVariantDrawCounts), 0);
+		for (const auto& frameJob : mFrameJobs)
+		{
+			mTriangleCount += frameJob.triangleCount;
+			mFullDetailTriangleCount += frameJob.fullDetailTriangleCount;
+			mMeshletCount += frameJob.meshletCount;
+			mVisibleMeshletCount += frameJob.visibleMeshletCount;
+		}
 
-		SkyboxUniforms skyboxUniforms;
-		skyboxUniforms.cameraPos = Utils::SponzaToGLMVec3(camera.getPosition());
-		skyboxUniforms.viewProjectionXform = projection * view;
-		mSkyboxShaderProgram.SetUniformBuffer("cpp_SkyboxUniforms", &skyboxUniforms, sizeof(skyboxUniforms));
+		// Replaying the command lists in job order so the queue does not depend on how the jobs were scheduled.
+		mRenderQueue.BeginFrame();
+		mRenderQueue.Clear();
+		for (const auto& frameJob : mFrameJobs)
+			mRenderQueue.Append(frameJob.commands.GetItems());
+		mRenderQueue.Sort();
+	}
 
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, mSkyboxTexture);
-		glBindVertexArray(mSkyboxVAO);
-		glDrawArrays(GL_TRIANGLES, 0, 36);
-		glBindVertexArray(0);
-		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-	}	
 
+	// -----------------Shadow passes-----------------
+
+	// Keeping the caller's framebuffer and viewport, which may be the benchmark's rather than the window's.
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
 
-	// --------------------Populating the per model uniform buffers--------------------
+	mShadowShaderProgram.Use();
+	glState.Enable(GL_DEPTH_TEST);
+	glState.DepthFunc(GL_LESS);
+	glState.Disable(GL_BLEND);
+	glState.Enable(GL_POLYGON_OFFSET_FILL);
+	glState.PolygonOffset(SHADOW_DEPTH_BIAS_FACTOR, SHADOW_DEPTH_BIAS_UNITS);
 
-	perModelUniforms.clear();
-	for (const auto& mesh : mMeshes)
 	{
-		int meshID = mesh.first;
-		auto instanceIDs = scene_->getInstancesByMeshId(meshID);
-		int instanceCount = instanceIDs.size();
+		ProfileScope profileScope(mProfiler, "Spot Shadows");
+		RenderSpotShadows(snapshot, frameView, (float)viewportSize[3]);
+	}
 
-		PerModelUniforms currentPerModelUniforms;
+	// Timed per cascade inside.
+	RenderDirectionalShadows(snapshot, view, aspectRatio);
 
-		// Loop through the instances and populate the uniform buffer block.
-		for (int i = 0; i < instanceCount; i++)
+	glState.Disable(GL_POLYGON_OFFSET_FILL);
+	glState.Disable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, previousFramebuffer);
+	glViewport(viewportSize[0], viewportSize[1], viewportSize[2], viewportSize[3]);
+
+
+	// -----------------Forward pass-----------------
+
+	if (mShadingMode == ShadingMode::Forward)
+	{
+		glState.Enable(GL_DEPTH_TEST);
+		glState.DepthMask(GL_TRUE);
+		glState.DepthFunc(GL_LESS);
+		glState.Disable(GL_BLEND);
+
+		// Uploading every light once, the fragments accumulate them in registers rather than by blending.
+		BuildLightArrayUniforms();
+		mForwardShaderPrograms[0].SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+		mForwardShaderPrograms[0].SetUniformBuffer("cpp_LightArrayUniforms", &mLightArrayUniforms, sizeof(mLightArrayUniforms));
+
+		// Binding both kinds of shadow map, each sampler type needs its own texture unit.
+		glState.BindTexture(1, GL_TEXTURE_2D_ARRAY, mCascadedShadowMaps.GetTexture());
+		glState.BindTexture(2, GL_TEXTURE_2D, mShadowAtlas.GetTexture());
+
+		// Drawing the variants one after the other, each timed as its own section so their costs can be compared.
+		for (int variant = 0; variant < SHADER_VARIANT_COUNT; variant++)
 		{
-			auto instance = scene_->getInstanceById(instanceIDs[i]);
-
-			// Setting the xforms in the uniform buffer.
-			currentPerModelUniforms.instances[i].modelXform = Utils::SponzaMat3ToGLMMat4(instance.getTransformationMatrix());
-			currentPerModelUniforms.instances[i].mvpXform = projection * view * currentPerModelUniforms.instances[i].modelXform;
-
-			// Setting the material properties in the uniform buffer.
-			auto material = scene_->getMaterialById(instance.getMaterialId());
-			currentPerModelUniforms.instances[i].diffuse = Utils::SponzaToGLMVec3(material.getDiffuseColour());
-			currentPerModelUniforms.instances[i].shininess = material.getShininess();
-			currentPerModelUniforms.instances[i].specular = Utils::SponzaToGLMVec3(material.getSpecularColour());
-			currentPerModelUniforms.instances[i].isShiny = material.isShiny();
+			size_t first, last;
+			mRenderQueue.GetProgramRange(RenderPass::Opaque, variant, first, last);
+			if (first == last) continue;
+
+			const std::string sectionName = "Forward " + ShaderPermutations::GetVariantName(variant);
+			ProfileScope profileScope(mProfiler, sectionName.c_str());
+			mForwardShaderPrograms[variant].Use();
+			mProgramSwitchCount++;
+			DrawItems(mForwardShaderPrograms[variant], first, last, true);
+			mVariantDrawCounts[variant] += last - first;
 		}
-		perModelUniforms.push_back(currentPerModelUniforms);
+
+		glState.BindTexture(1, GL_TEXTURE_2D_ARRAY, 0);
+		glState.BindTexture(2, GL_TEXTURE_2D, 0);
+
+		if (mRenderSkybox && mSkyboxMode == SkyboxMode::FullscreenTriangle)
+			DrawSkybox(projection * view, perFrameUniforms.cameraPos);
+
+		FinishFrame(viewportSize);
+		return;
 	}
 
 
 	// -----------------Ambient pass-----------------
 
-	mAmbShaderProgram.Use();
-	glEnable(GL_DEPTH_TEST);
-	glDepthMask(GL_TRUE);	
-	glDepthFunc(GL_LESS);
-	glDisable(GL_BLEND);
+	{
+		ProfileScope profileScope(mProfiler, "Ambient");
+		mAmbShaderProgram.Use();
+		glState.Enable(GL_DEPTH_TEST);
+		glState.DepthMask(GL_TRUE);	
+		glState.DepthFunc(GL_LESS);
+		glState.Disable(GL_BLEND);
 
-	// Setting the per frame uniform buffer.
-	mAmbShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+		// Setting the per frame uniform buffer.
+		mAmbShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
 
-	DrawMeshesInstanced(mAmbShaderProgram);
+		DrawMeshesInstanced(mAmbShaderProgram, RenderPass::Opaque);
+	}
 
 
 	// -----------------Directional Light pass-----------------
 
-	mDirShaderProgram.Use();
-	glDepthMask(GL_FALSE);
-	glDepthFunc(GL_EQUAL);
-	glEnable(GL_BLEND);
-	glBlendEquation(GL_FUNC_ADD);
-	glBlendFunc(GL_ONE, GL_ONE);
+	{
+		ProfileScope profileScope(mProfiler, "Directional");
+		mDirShaderProgram.Use();
+		glState.DepthMask(GL_FALSE);
+		glState.DepthFunc(GL_EQUAL);
+		glState.Enable(GL_BLEND);
+		glState.BlendEquation(GL_FUNC_ADD);
+		glState.BlendFunc(GL_ONE, GL_ONE);
+
+		// Setting the per frame uniform buffer.
+		mDirShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+
+		// Binding the cascades to texture unit 1, leaving unit 0 to the material textures.
+		glState.BindTexture(1, GL_TEXTURE_2D_ARRAY, mCascadedShadowMaps.GetTexture());
+
+		// The directional term has no specular, so every variant would build the same program and one draws them all.
+		for (const auto& directionalLightUniform : mDirectionalLightUniforms)
+		{
+			mDirShaderProgram.SetUniformBuffer("cpp_DirectionalLightUniforms", &directionalLightUniform, sizeof(directionalLightUniform));
+
+			DrawMeshesInstanced(mDirShaderProgram, RenderPass::Lighting);
+		}
+
+		glState.BindTexture(1, GL_TEXTURE_2D_ARRAY, 0);
+	}
+
 
-	// Setting the per frame uniform buffer.
-	mDirShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+	// -----------------Point Light pass-----------------
+
+	// Setting the per frame uniform buffer, which every variant shares.
+	mPointShaderPrograms[0].SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
 
-	for (const auto& light : scene_->getAllDirectionalLights())
+	// Blending every light of one variant before the next, each variant timed as its own section.
+	for (int variant = 0; variant < SHADER_VARIANT_COUNT; variant++)
 	{
-		DirectionalLightUniforms directionalLightUniform;
-		directionalLightUniform.light.direction = Utils::SponzaToGLMVec3(light.getDirection());
-		directionalLightUniform.light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
-		mDirShaderProgram.SetUniformBuffer("cpp_DirectionalLightUniforms", &directionalLightUniform, sizeof(directionalLightUniform));
+		size_t first, last;
+		mRenderQueue.GetProgramRange(RenderPass::Lighting, variant, first, last);
+		if (first == last) continue;
+
+		const std::string sectionName = "Point " + ShaderPermutations::GetVariantName(variant);
+		ProfileScope profileScope(mProfiler, sectionName.c_str());
+		mPointShaderPrograms[variant].Use();
+		mProgramSwitchCount++;
+		for (const auto& pointLightUniform : mPointLightUniforms)
+		{
+			mPointShaderPrograms[variant].SetUniformBuffer("cpp_PointLightUniforms", &pointLightUniform, sizeof(pointLightUniform));
 
-		DrawMeshesInstanced(mDirShaderProgram);
+			DrawItems(mPointShaderPrograms[variant], first, last, true);
+			mVariantDrawCounts[variant] += last - first;
+		}
 	}
 
 
-	// -----------------Point Light pass-----------------
+	// -----------------Spot Light pass-----------------
+
+	{
+		ProfileScope profileScope(mProfiler, "Spot");
+		mSpotShaderProgram.Use();
+
+		// Setting the per frame uniform buffer.
+		mSpotShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+
+		// Binding the shadow atlas to texture unit 1, leaving unit 0 to the material textures.
+		glState.BindTexture(1, GL_TEXTURE_2D, mShadowAtlas.GetTexture());
+
+		// As with the directional pass, the spot term has no specular so the pass is not split by variant.
+		for (const auto& spotLightUniform : mSpotLightUniforms)
+		{
+			mSpotShaderProgram.SetUniformBuffer("cpp_SpotLightUniforms", &spotLightUniform, sizeof(spotLightUniform));
+
+			DrawMeshesInstanced(mSpotShaderProgram, RenderPass::Lighting);
+		}
+
+		glState.BindTexture(1, GL_TEXTURE_2D, 0);
+	}
 
-	mPointShaderProgram.Use();
 
-	// Setting the per frame uniform buffer.
-	mPointShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
+	// --------------------Skybox--------------------
+
+	if (mRenderSkybox && mSkyboxMode == SkyboxMode::FullscreenTriangle)
+		DrawSkybox(projection * view, perFrameUniforms.cameraPos);
+
+	FinishFrame(viewportSize);
+}
+
+
+void MyView::DrawMeshesInstanced(ShaderProgram& shaderProgram, RenderPass pass)
+{
+	size_t first, last;
+	mRenderQueue.GetPassRange(pass, first, last);
+	DrawItems(shaderProgram, first, last);
+}
 
-	for (const auto& light : scene_->getAllPointLights())
+
+void MyView::DrawItems(ShaderProgram& shaderProgram, size_t first, size_t last, bool perVariantPrograms)
+{
+	// The sampler was pointed at texture unit 0 on start, the queue only rebinds the texture when it changes.
+	for (size_t i = first; i < last; i++)
 	{
-		PointLightUniforms pointLightUniform;
-		pointLightUniform.light.position = Utils::SponzaToGLMVec3(light.getPosition());
-		pointLightUniform.light.range = light.getRange();
-		pointLightUniform.light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
-		mPointShaderProgram.SetUniformBuffer("cpp_PointLightUniforms", &pointLightUniform, sizeof(pointLightUniform));
+		const DrawItem& item = mRenderQueue.GetItem(i);
 
-		DrawMeshesInstanced(mPointShaderProgram);
+		UploadInstances(shaderProgram, perModelUniforms[item.uniformIndex], item.firstInstance, item.instanceCount);
+
+		mRenderQueue.BindItemState(item, perVariantPrograms);
+		glDrawElementsInstanced(GL_TRIANGLES, item.elementCount, GL_UNSIGNED_INT,
+			TGL_BUFFER_OFFSET(item.firstElement * sizeof(unsigned int)), item.instanceCount);
+		RenderStats::Instance().AddDraw(item.instanceCount, item.elementCount / 3);
 	}
+}
 
 
-	// -----------------Spot Light pass-----------------
+void MyView::DrawSkybox(const glm::mat4& viewProjection, const glm::vec3& cameraPos)
+{
+	ProfileScope profileScope(mProfiler, "Skybox");
+	GLStateCache& glState = GLStateCache::Instance();
+	glState.Disable(GL_BLEND);
+	glState.BindTexture(0, GL_TEXTURE_CUBE_MAP, mTextureLoader.GetTexture(mSkyboxTexture));
 
-	mSpotShaderProgram.Use();
+	if (mSkyboxMode == SkyboxMode::Cube)
+	{
+		mSkyboxShaderProgram.Use();
+		glState.Disable(GL_DEPTH_TEST);
+
+		SkyboxUniforms skyboxUniforms;
+		skyboxUniforms.cameraPos = cameraPos;
+		skyboxUniforms.viewProjectionXform = viewProjection;
+		mSkyboxShaderProgram.SetUniformBuffer("cpp_SkyboxUniforms", &skyboxUniforms, sizeof(skyboxUniforms));
+
+		glState.BindVertexArray(mSkyboxVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 36);
+		RenderStats::Instance().AddDraw(1, 12);
+	}
+	else
+	{
+		// Testing against the finished depth buffer on the far plane, so early-z rejects every pixel of geometry.
+		mSkyboxTriangleShaderProgram.Use();
+		glState.Enable(GL_DEPTH_TEST);
+		glState.DepthFunc(GL_LEQUAL);
+		glState.DepthMask(GL_FALSE);
+
+		SkyboxTriangleUniforms skyboxUniforms;
+		skyboxUniforms.inverseViewProjectionXform = glm::inverse(viewProjection);
+		skyboxUniforms.cameraPos = cameraPos;
+		mSkyboxTriangleShaderProgram.SetUniformBuffer("cpp_SkyboxTriangleUniforms", &skyboxUniforms, sizeof(skyboxUniforms));
+
+		glState.BindVertexArray(mSkyboxTriangleVAO);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		RenderStats::Instance().AddDraw(1, 1);
+	}
+}
+
+
+void MyView::UploadInstances(ShaderProgram& shaderProgram, const PerModelUniforms& uniforms, int firstInstance, int instanceCount)
+{
+	// Uploading only the range of instances being drawn, which the shader then indexes from zero.
+	shaderProgram.SetUniformBuffer("cpp_PerModelUniforms", &uniforms.xforms[firstInstance], instanceCount * sizeof(InstanceXform));
+	shaderProgram.SetUniformBuffer("cpp_PerModelUniforms", &uniforms.materialIndices[firstInstance], instanceCount * sizeof(int),
+		offsetof(PerModelUniforms, materialIndices));
+}
 
-	// Setting the per frame uniform buffer.
-	mSpotShaderProgram.SetUniformBuffer("cpp_PerFrameUniforms", &perFrameUniforms, sizeof(perFrameUniforms));
 
+void MyView::RegisterMeshes()
+{
+	// Caching each new mesh's instance indices and material indices alongside it in the dense mesh table.
+	const size_t meshCount = mMeshLoader.GetMeshCount();
+	if (mMeshIds.size() == meshCount) return;
+	mMeshIds.resize(meshCount);
+	mMeshInstanceIndices.resize(meshCount);
+	mMeshInstanceMaterials.resize(meshCount);
+	for (MeshHandle handle = 0; handle < meshCount; handle++)
+	{
+		mMeshIds[handle] = mMeshLoader.GetMeshId(handle);
+		mMeshInstanceIndices[handle].clear();
+		mMeshInstanceMaterials[handle].clear();
+		for (const auto& instanceID : scene_->getInstancesByMeshId(mMeshIds[handle]))
+		{
+			mMeshInstanceIndices[handle].push_back(mInstanceIndices[instanceID]);
+			mMeshInstanceMaterials[handle].push_back(mMaterials.GetMaterialIndex(scene_->getInstanceById(instanceID).getMaterialId()));
+		}
+	}
+	perModelUniforms.resize(meshCount);
+	mMeshRequests.resize(meshCount);
+}
 
-	for (const auto& light : scene_->getAllSpotLights())
+void MyView::BuildMeshCommands(const SceneSnapshot& snapshot, const FrameView& frameView, int job, int jobCount)
+{
+	FrameJob& frameJob = mFrameJobs[job];
+	frameJob.commands.Clear();
+	frameJob.triangleCount = 0;
+	frameJob.fullDetailTriangleCount = 0;
+	frameJob.meshletCount = 0;
+	frameJob.visibleMeshletCount = 0;
+
+	// Each job owns a contiguous range of meshes, and so the matching slots of the uniform array.
+	const MeshHandle first = mMeshIds.size() * job / jobCount;
+	const MeshHandle last = mMeshIds.size() * (job + 1) / jobCount;
+	for (MeshHandle handle = first; handle < last; handle++)
 	{
-		SpotLightUniforms spotLightUniform;
-		spotLightUniform.light.position = Utils::SponzaToGLMVec3(light.getPosition());
-		spotLightUniform.light.range = light.getRange();
-		spotLightUniform.light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
-		spotLightUniform.light.angle = light.getConeAngleDegrees();
-		spotLightUniform.light.direction = Utils::SponzaToGLMVec3(light.getDirection());
-		mSpotShaderProgram.SetUniformBuffer("cpp_SpotLightUniforms", &spotLightUniform, sizeof(spotLightUniform));
+		const auto& mesh = mMeshLoader.GetMesh(handle);
+		const auto& instanceIndices = mMeshInstanceIndices[handle];
+		int instanceCount = instanceIndices.size();
+
+		// Requesting the mesh by the distance to its nearest instance, and whether any instance is in view.
+		MeshRequest& request = mMeshRequests[handle];
+		request.distance = std::numeric_limits<float>::max();
+		request.visible = !mesh.hasBounds && instanceCount > 0;
+		for (int i = 0; i < instanceCount && mesh.hasBounds; i++)
+		{
+			const glm::mat4& xform = snapshot.instanceXforms[instanceIndices[i]];
+			const glm::vec3 centre = glm::vec3(xform * glm::vec4(mesh.boundsCentre, 1.0f));
+			const float radius = Utils::TransformRadius(xform, mesh.boundsRadius);
+			request.distance = std::min(request.distance, std::max(0.0f, glm::length(centre - frameView.cameraPos) - radius));
+			request.visible |= Utils::IsSphereInFrustum(frameView.frustumPlanes, centre, radius);
+		}
+
+		// Skipping meshes which are still streaming in.
+		if (instanceCount == 0 || mesh.elementCount == 0) continue;
+
+		// Picking the coarsest level of detail whose error projects to less than a pixel for each instance.
+		auto& instanceOrder = frameJob.instanceOrder;
+		instanceOrder.clear();
+		for (int i = 0; i < instanceCount; i++)
+		{
+			const glm::mat4& xform = snapshot.instanceXforms[instanceIndices[i]];
+			const float depth = glm::dot(glm::vec3(xform[3]) - frameView.cameraPos, frameView.cameraDir);
+			const glm::vec3 centre = glm::vec3(xform * glm::vec4(mesh.boundsCentre, 1.0f));
+			const float distance = glm::length(centre - frameView.cameraPos) - Utils::TransformRadius(xform, mesh.boundsRadius);
+			const float scale = Utils::TransformRadius(xform, frameView.lodScale);
+			int lod = mesh.lods.size() - 1;
+			while (lod > 0 && (distance <= 0.0f || mesh.lods[lod].error * scale > MESH_LOD_PIXEL_ERROR * distance))
+				lod--;
+
+			// Shading each instance with the cheapest variant its material allows, or the full one when disabled.
+			const MaterialData& material = mMaterials.GetUniforms().materials[mMeshInstanceMaterials[handle][i]];
+			const uint32_t variant = mUseShaderVariants ? ShaderPermutations::GetMaterialFeatures(material) : SHADER_VARIANT_ALL;
+			instanceOrder.push_back({ lod, variant, depth, i });
+		}
+
+		// Grouping the instances by level of detail and shader variant, each group sorted front-to-back.
+		std::sort(instanceOrder.begin(), instanceOrder.end(), [](const InstanceOrder& a, const InstanceOrder& b)
+		{
+			if (a.lod != b.lod) return a.lod < b.lod;
+			return a.variant != b.variant ? a.variant < b.variant : a.depth < b.depth;
+		});
+
+		// Writing straight into the mesh's slot of the persistent uniform array.
+		PerModelUniforms& currentPerModelUniforms = perModelUniforms[handle];
+
+		// Loop through the instances and populate the uniform buffer block.
+		for (int i = 0; i < instanceCount; i++)
+		{
+			const int localIndex = instanceOrder[i].index;
+
+			// Setting the xform in the uniform buffer, the view projection is applied in the vertex shader.
+			Utils::ToAffineRows(snapshot.instanceXforms[instanceIndices[localIndex]], currentPerModelUniforms.xforms[i].rows);
+
+			// Setting the index into the material table.
+			currentPerModelUniforms.materialIndices[i] = mMeshInstanceMaterials[handle][localIndex];
+		}
+
+		// Recording each group of instances for the opaque pass and the lighting passes.
+		for (int groupStart = 0, groupEnd = 0; groupStart < instanceCount; groupStart = groupEnd)
+		{
+			const MeshLod& lod = mesh.lods[instanceOrder[groupStart].lod];
+			while (groupEnd < instanceCount && instanceOrder[groupEnd].lod == instanceOrder[groupStart].lod
+				&& instanceOrder[groupEnd].variant == instanceOrder[groupStart].variant)
+				groupEnd++;
+
+			DrawItem item;
+			item.firstElement = lod.firstElement;
+			item.elementCount = lod.elementCount;
+			item.firstInstance = groupStart;
+			item.instanceCount = groupEnd - groupStart;
+			item.uniformIndex = handle;
+			item.program = instanceOrder[groupStart].variant;
+			const float depth = instanceOrder[groupStart].depth / frameView.farPlane;
+
+			// Culling the meshlets of full detail instances one instance at a time, as each sees different clusters.
+			if (instanceOrder[groupStart].lod == 0 && !mesh.meshlets.empty())
+			{
+				for (int i = groupStart; i < groupEnd; i++)
+				{
+					item.firstInstance = i;
+					item.instanceCount = 1;
+					PushMeshletRanges(frameJob, frameView, mesh, snapshot.instanceXforms[instanceIndices[instanceOrder[i].index]], item,
+						instanceOrder[i].depth / frameView.farPlane);
+				}
+				continue;
+			}
+
+			frameJob.commands.Push(RenderPass::Opaque, item.program, frameView.texture, mesh.vao, depth, item);
+			frameJob.commands.Push(RenderPass::Lighting, item.program, frameView.texture, mesh.vao, depth, item);
+			frameJob.triangleCount += (lod.elementCount / 3) * item.instanceCount;
+		}
+		frameJob.fullDetailTriangleCount += (mesh.elementCount / 3) * instanceCount;
+	}
+}
 
-		DrawMeshesInstanced(mSpotShaderProgram);
+void MyView::PushMeshletRanges(FrameJob& frameJob, const FrameView& frameView, const MeshData& mesh, const glm::mat4& xform,
+	DrawItem item, float depth)
+{
+	// Testing the normal cones in model space, so only the camera is transformed.
+	const glm::vec3 cameraPos = glm::vec3(glm::inverse(xform) * glm::vec4(frameView.cameraPos, 1.0f));
+	const float scale = Utils::TransformRadius(xform, 1.0f);
+
+	// Drawing the visible meshlets as contiguous ranges, bridging small gaps of culled ones to save draws.
+	int rangeStart = -1;
+	int rangeEnd = -1;
+	int gap = 0;
+	const int meshletCount = mesh.meshlets.size();
+	for (int i = 0; i <= meshletCount; i++)
+	{
+		const bool visible = i < meshletCount
+			&& !MeshletBuilder::IsBackFacing(mesh.meshlets[i], cameraPos)
+			&& !MeshletBuilder::IsOutsideFrustum(mesh.meshlets[i], xform, frameView.frustumPlanes, scale);
+		if (visible)
+		{
+			frameJob.visibleMeshletCount++;
+			if (rangeStart < 0) rangeStart = i;
+			rangeEnd = i + 1;
+			gap = 0;
+			continue;
+		}
+		if (rangeStart < 0 || (i < meshletCount && ++gap <= MESHLET_MERGE_GAP)) continue;
+
+		item.firstElement = mesh.meshlets[rangeStart].firstElement;
+		item.elementCount = mesh.meshlets[rangeEnd - 1].firstElement + mesh.meshlets[rangeEnd - 1].elementCount - item.firstElement;
+		frameJob.commands.Push(RenderPass::Opaque, item.program, frameView.texture, mesh.vao, depth, item);
+		frameJob.commands.Push(RenderPass::Lighting, item.program, frameView.texture, mesh.vao, depth, item);
+		frameJob.triangleCount += item.elementCount / 3;
+		rangeStart = -1;
 	}
+	frameJob.meshletCount += meshletCount;
 }
 
+void MyView::BuildLightUniforms(const SceneSnapshot& snapshot)
+{
+	mDirectionalLightUniforms.resize(snapshot.directionalLights.size());
+	for (size_t i = 0; i < snapshot.directionalLights.size(); i++)
+	{
+		const auto& light = snapshot.directionalLights[i];
+		mDirectionalLightUniforms[i].light.direction = Utils::SponzaToGLMVec3(light.getDirection());
+		mDirectionalLightUniforms[i].light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
+	}
+
+	mPointLightUniforms.resize(snapshot.pointLights.size());
+	for (size_t i = 0; i < snapshot.pointLights.size(); i++)
+	{
+		const auto& light = snapshot.pointLights[i];
+		mPointLightUniforms[i].light.position = Utils::SponzaToGLMVec3(light.getPosition());
+		mPointLightUniforms[i].light.range = light.getRange();
+		mPointLightUniforms[i].light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
+	}
+
+	mSpotLightUniforms.resize(snapshot.spotLights.size());
+	for (size_t i = 0; i < snapshot.spotLights.size(); i++)
+	{
+		const auto& light = snapshot.spotLights[i];
+		mSpotLightUniforms[i].light.position = Utils::SponzaToGLMVec3(light.getPosition());
+		mSpotLightUniforms[i].light.range = light.getRange();
+		mSpotLightUniforms[i].light.intensity = Utils::SponzaToGLMVec3(light.getIntensity());
+		mSpotLightUniforms[i].light.angle = light.getConeAngleDegrees();
+		mSpotLightUniforms[i].light.direction = Utils::SponzaToGLMVec3(light.getDirection());
+	}
+}
 
-void MyView::LoadTexture(std::string name)
+void MyView::RenderSpotShadows(const SceneSnapshot& snapshot, const FrameView& frameView, float viewportHeight)
 {
-	//Checking the texture is not already loaded.
-	if (mTextures.find(name) != mTextures.end()) return;
+	const size_t lightCount = mSpotLightUniforms.size();
+	mSpotShadowStates.resize(lightCount);
+	mShadowRenderCount = 0;
+	mShadowTileCount = 0;
+
+	// Collecting the world space spheres of the instances which moved since the last frame, at both ends of the move.
+	std::vector<glm::vec4> movedSpheres;
+	if (mPreviousInstanceXforms.size() == snapshot.instanceXforms.size())
+	{
+		for (MeshHandle handle = 0; handle < mMeshIds.size(); handle++)
+		{
+			const auto& mesh = mMeshLoader.GetMesh(handle);
+			if (!mesh.hasBounds) continue;
+			for (int index : mMeshInstanceIndices[handle])
+			{
+				const glm::mat4& xform = snapshot.instanceXforms[index];
+				const glm::mat4& previousXform = mPreviousInstanceXforms[index];
+				if (xform == previousXform) continue;
+				movedSpheres.push_back(glm::vec4(glm::vec3(xform * glm::vec4(mesh.boundsCentre, 1.0f)),
+					Utils::TransformRadius(xform, mesh.boundsRadius)));
+				movedSpheres.push_back(glm::vec4(glm::vec3(previousXform * glm::vec4(mesh.boundsCentre, 1.0f)),
+					Utils::TransformRadius(previousXform, mesh.boundsRadius)));
+			}
+		}
+	}
+	mPreviousInstanceXforms.assign(snapshot.instanceXforms.begin(), snapshot.instanceXforms.end());
+
+	// Meshes streaming in or out change what every cached shadow should contain.
+	const bool residencyChanged = mMeshLoader.GetResidentCount() != mShadowResidentCount;
+	mShadowResidentCount = mMeshLoader.GetResidentCount();
+
+	// Ranking the lights by the fraction of the screen height their sphere of influence covers, lights out of
+	// view or not casting shadows get no tile.
+	std::vector<float> importance(lightCount, 0.0f);
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		SpotLight& light = mSpotLightUniforms[i].light;
+		light.castShadow = 0;
+		if (!snapshot.spotLights[i].getCastShadow()) continue;
+		if (!Utils::IsSphereInFrustum(frameView.frustumPlanes, light.position, light.range)) continue;
 
-	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		const float distance = glm::length(light.position - frameView.cameraPos);
+		importance[i] = distance <= light.range ? 1.0f : 2.0f * light.range * frameView.lodScale / (distance * viewportHeight);
+	}
+	mShadowAtlas.AllocateTiles(importance);
+
+	for (size_t i = 0; i < lightCount; i++)
+	{
+		if (!mShadowAtlas.HasTile(i)) continue;
+		ShadowTile& tile = mShadowAtlas.GetTile(i);
+		SpotLight& light = mSpotLightUniforms[i].light;
+
+		// Covering the cone spot_fs.glsl lights, which compares the cosine of the angle to the fragment against
+		// half the cone angle in radians.
+		const float halfAngle = std::acos(std::min(1.0f, glm::radians(light.angle * 0.5f)));
+		const float fov = std::min(170.0f, glm::degrees(halfAngle) * 2.0f + SHADOW_FOV_MARGIN_DEGREES);
+		const glm::vec3 direction = glm::normalize(light.direction);
+		const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		const glm::mat4 viewProjection = glm::perspective(glm::radians(fov), 1.0f, light.range * SHADOW_NEAR_PLANE_RATIO, light.range)
+			* glm::lookAt(light.position, light.position + direction, up);
+		glm::vec4 lightFrustumPlanes[6];
+		Utils::ExtractFrustumPlanes(viewProjection, lightFrustumPlanes);
+
+		// A static light keeps its cached shadow until the light changes or something moves inside its frustum.
+		SpotShadowState& state = mSpotShadowStates[i];
+		bool render = !tile.cached || !snapshot.spotLights[i].isStatic() || residencyChanged
+			|| state.position != light.position || state.direction != light.direction
+			|| state.angle != light.angle || state.range != light.range;
+		for (size_t j = 0; j < movedSpheres.size() && !render; j++)
+			render = Utils::IsSphereInFrustum(lightFrustumPlanes, glm::vec3(movedSpheres[j]), movedSpheres[j].w);
+
+		if (render)
+		{
+			state.position = light.position;
+			state.direction = light.direction;
+			state.angle = light.angle;
+			state.range = light.range;
+			tile.viewProjection = viewProjection;
+
+			mShadowAtlas.BeginTile(tile);
+			ShadowUniforms shadowUniforms;
+			shadowUniforms.lightViewProjectionXform = viewProjection;
+			mShadowShaderProgram.SetUniformBuffer("cpp_ShadowUniforms", &shadowUniforms, sizeof(shadowUniforms));
+			DrawShadowCasters(lightFrustumPlanes);
+			tile.cached = true;
+			mShadowRenderCount++;
+		}
 
-	//Loading the texture.
-	tygra::Image texture = tygra::createImageFromPngFile(name);
+		light.castShadow = 1;
+		light.shadowXform = mShadowAtlas.GetTextureXform(tile);
+		mShadowTileCount++;
+	}
+	GLStateCache::Instance().Disable(GL_SCISSOR_TEST);
+}
 
-	//Checking the texture contains data.
-	if (texture.doesContainData())
+void MyView::RenderDirectionalShadows(const SceneSnapshot& snapshot, const glm::mat4& view, float aspectRatio)
+{
+	const sponza::Camera& camera = snapshot.camera;
+	const int lightCount = std::min<int>(mDirectionalLightUniforms.size(), mCascadedShadowMaps.GetLightCount());
+	for (auto& directionalLightUniform : mDirectionalLightUniforms)
+		directionalLightUniform.light.castShadow = 0;
+	for (int light = 0; light < lightCount; light++)
 	{
-		//Loading the texture and storing its ID in the 'textures' map.
-		glGenTextures(1, &mTextures[name]);
-		glBindTexture(GL_TEXTURE_2D, mTextures[name]);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		GLenum pixel_formats[] = { 0, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+		mCascadedShadowMaps.FitCascades(light, mDirectionalLightUniforms[light].light.direction, view,
+			glm::radians(camera.getVerticalFieldOfViewInDegrees()), aspectRatio, camera.getNearPlaneDistance(),
+			camera.getFarPlaneDistance());
+	}
 
-		glTexImage2D(GL_TEXTURE_2D,
-			0,
-			GL_RGBA,
-			texture.width(),
-			texture.height(),
-			0,
-			pixel_formats[texture.componentsPerPixel()],
-			texture.bytesPerComponent() == 1 ? GL_UNSIGNED_BYTE
-			: GL_UNSIGNED_SHORT,
-			texture.pixelData());
+	// Timing each cascade across the lights, so the profile shows what every level of the split costs.
+	mCascadeRenderCount = 0;
+	for (int cascade = 0; cascade < CSM_CASCADE_COUNT; cascade++)
+	{
+		const std::string sectionName = "Cascade " + std::to_string(cascade);
+		ProfileScope profileScope(mProfiler, sectionName.c_str());
+		for (int light = 0; light < lightCount; light++)
+		{
+			// A cascade which has not moved is refreshed every other frame, staggered so half of them update each frame.
+			ShadowCascade& current = mCascadedShadowMaps.GetCascade(light, cascade);
+			const bool moved = !current.cached || current.viewProjection != current.renderedViewProjection;
+			if (!moved && (snapshot.frameIndex + cascade + light) % 2 != 0) continue;
+
+			glm::vec4 lightFrustumPlanes[6];
+			Utils::ExtractFrustumPlanes(current.viewProjection, lightFrustumPlanes);
+			mCascadedShadowMaps.BeginCascade(light, cascade);
+			ShadowUniforms shadowUniforms;
+			shadowUniforms.lightViewProjectionXform = current.viewProjection;
+			mShadowShaderProgram.SetUniformBuffer("cpp_ShadowUniforms", &shadowUniforms, sizeof(shadowUniforms));
+			DrawShadowCasters(lightFrustumPlanes);
+			current.renderedViewProjection = current.viewProjection;
+			current.cached = true;
+			mCascadeRenderCount++;
+		}
+	}
 
-		glGenerateMipmap(GL_TEXTURE_2D);
-		glBindTexture(GL_TEXTURE_2D, 0);
+	for (int light = 0; light < lightCount; light++)
+	{
+		DirectionalLight& uniformLight = mDirectionalLightUniforms[light].light;
+		uniformLight.castShadow = 1;
+		uniformLight.firstLayer = mCascadedShadowMaps.GetLayer(light, 0);
+		for (int cascade = 0; cascade < CSM_CASCADE_COUNT; cascade++)
+			uniformLight.cascadeXforms[cascade] = mCascadedShadowMaps.GetTextureXform(light, cascade);
 	}
-	else std::cerr << "Warning : Texture '" << name << "' does not contain any data." << std::endl;
 }
 
-void MyView::DrawMeshesInstanced(ShaderProgram& shaderProgram)
+void MyView::DrawShadowCasters(const glm::vec4 lightFrustumPlanes[6])
 {
-	int i = 0;
-	for (const auto& mesh : mMeshes)
+	// Drawing the instances of every resident mesh inside the light's frustum at full detail, reusing the
+	// instance xforms the command jobs wrote this frame.
+	for (MeshHandle handle = 0; handle < mMeshIds.size(); handle++)
 	{
-		int meshID = mesh.first;
-		auto instanceIDs = scene_->getInstancesByMeshId(meshID);
-		int instanceCount = instanceIDs.size();
+		const auto& mesh = mMeshLoader.GetMesh(handle);
+		const int instanceCount = mMeshInstanceIndices[handle].size();
+		if (instanceCount == 0 || mesh.elementCount == 0) continue;
+
+		// Gathering the instances which survive the light's culling into the front of the scratch block.
+		const PerModelUniforms& uniforms = perModelUniforms[handle];
+		int casterCount = 0;
+		for (int i = 0; i < instanceCount; i++)
+		{
+			const glm::mat4 xform = Utils::FromAffineRows(uniforms.xforms[i].rows);
+			const glm::vec3 centre = glm::vec3(xform * glm::vec4(mesh.boundsCentre, 1.0f));
+			if (!Utils::IsSphereInFrustum(lightFrustumPlanes, centre, Utils::TransformRadius(xform, mesh.boundsRadius))) continue;
+			mShadowInstances.xforms[casterCount] = uniforms.xforms[i];
+			mShadowInstances.materialIndices[casterCount] = uniforms.materialIndices[i];
+			casterCount++;
+		}
+		if (casterCount == 0) continue;
+
+		UploadInstances(mShadowShaderProgram, mShadowInstances, 0, casterCount);
+		GLStateCache::Instance().BindVertexArray(mesh.vao);
+		const MeshLod& lod = mesh.lods.front();
+		glDrawElementsInstanced(GL_TRIANGLES, lod.elementCount, GL_UNSIGNED_INT,
+			TGL_BUFFER_OFFSET(lod.firstElement * sizeof(unsigned int)), casterCount);
+		RenderStats::Instance().AddDraw(casterCount, lod.elementCount / 3);
+	}
+}
+
+void MyView::BuildLightArrayUniforms()
+{
+	// Packing the lights, with their shadow parameters from this frame, into the single light array block.
+	mLightArrayUniforms.directionalLightCount = std::min<int>(mDirectionalLightUniforms.size(), MAX_DIRECTIONAL_LIGHT_COUNT);
+	for (int i = 0; i < mLightArrayUniforms.directionalLightCount; i++)
+		mLightArrayUniforms.directionalLights[i] = mDirectionalLightUniforms[i].light;
+
+	mLightArrayUniforms.pointLightCount = std::min<int>(mPointLightUniforms.size(), MAX_LIGHT_COUNT);
+	for (int i = 0; i < mLightArrayUniforms.pointLightCount; i++)
+		mLightArrayUniforms.pointLights[i] = mPointLightUniforms[i].light;
+
+	mLightArrayUniforms.spotLightCount = std::min<int>(mSpotLightUniforms.size(), MAX_LIGHT_COUNT);
+	for (int i = 0; i < mLightArrayUniforms.spotLightCount; i++)
+		mLightArrayUniforms.spotLights[i] = mSpotLightUniforms[i].light;
+}
+
+void MyView::FinishFrame(const GLint viewportSize[4])
+{
+	// The overlay is drawn over the finished frame and shows the counters of the frames before it.
+	if (mShowStatsOverlay)
+		DrawStatsOverlay(viewportSize[2], viewportSize[3]);
 
-		shaderProgram.SetUniformBuffer("cpp_PerModelUniforms", &(perModelUniforms[i]), sizeof((perModelUniforms[i])));
-		shaderProgram.SetTextureUniform(mTextures["resource:///marble.png"], "cpp_Texture");
+	RenderStats::Instance().EndFrame();
+	mProfiler.EndFrame();
+}
 
-		mesh.second.BindVAO();
-		glDrawElementsInstanced(GL_TRIANGLES, mesh.second.elementCount, GL_UNSIGNED_INT, 0, instanceCount);
-		glBindVertexArray(0);
+void MyView::DrawStatsOverlay(int width, int height)
+{
+	ProfileScope profileScope(mProfiler, "Overlay");
+	const RenderStats& stats = RenderStats::Instance();
+
+	// Laying out one line per counter with its last frame and rolling average, the upload counters in kilobytes.
+	std::vector<std::string> lines;
+	std::ostringstream line;
+	line << std::left << std::setw(24) << "RENDER STATS" << std::right << std::setw(10) << "LAST"
+		<< std::setw(10) << ("AVG(" + std::to_string(RENDER_STATS_AVERAGE_FRAMES) + ")");
+	lines.push_back(line.str());
+	for (size_t i = 0; i < (size_t)RenderCounter::Count; i++)
+	{
+		const RenderCounter counter = (RenderCounter)i;
+		const bool bytes = counter >= RenderCounter::UniformBytesUploaded;
+		std::string name = RenderStats::GetCounterName(counter);
+		std::replace(name.begin(), name.end(), '_', ' ');
+		if (bytes) name += " (KB)";
+
+		const double scale = bytes ? 1.0 / 1024.0 : 1.0;
+		line.str("");
+		line << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(0)
+			<< std::setw(10) << stats.GetLastFrame(counter) * scale << std::setw(10) << stats.GetAverage(counter) * scale;
+		lines.push_back(line.str());
+	}
+	const auto& glStats = GLStateCache::Instance().GetLastFrameStats();
+	line.str("");
+	line << std::left << std::setw(24) << "gl state calls issued" << std::right << std::setw(10) << glStats.issuedCalls;
+	lines.push_back(line.str());
+	line.str("");
+	line << std::left << std::setw(24) << "gl state calls skipped" << std::right << std::setw(10) << glStats.skippedCalls;
+	lines.push_back(line.str());
+
+	mOverlayUniforms.screenSize = glm::vec2(width, height);
+	mOverlayUniforms.glyphScale = OVERLAY_GLYPH_SCALE;
+	const float lineHeight = 6.0f * OVERLAY_GLYPH_SCALE;
+	int glyphCount = 0;
+	for (size_t i = 0; i < lines.size(); i++)
+		glyphCount = PushOverlayText(glyphCount, lines[i], lineHeight, lineHeight * (i + 1));
+	if (glyphCount == 0) return;
+
+	// Leaving the overlay out of the counters, so showing it does not change what it reports.
+	RenderStats::Instance().SetPaused(true);
+	mOverlayShaderProgram.Use();
+	mOverlayShaderProgram.SetUniformBuffer("cpp_OverlayUniforms", &mOverlayUniforms,
+		offsetof(OverlayUniforms, glyphs) + glyphCount * sizeof(glm::vec4));
+
+	GLStateCache& glState = GLStateCache::Instance();
+	glState.Disable(GL_DEPTH_TEST);
+	glState.Enable(GL_BLEND);
+	glState.BlendEquation(GL_FUNC_ADD);
+	glState.BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glState.BindVertexArray(mOverlayVAO);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, glyphCount);
+	RenderStats::Instance().SetPaused(false);
+}
 
-		i++;
+int MyView::PushOverlayText(int glyphCount, const std::string& text, float x, float y)
+{
+	// Appending a glyph per character, looking each up in the font's character set.
+	static const std::string charset = OVERLAY_CHARSET;
+	const float advance = 4.0f * OVERLAY_GLYPH_SCALE;
+	for (size_t i = 0; i < text.size() && glyphCount < MAX_OVERLAY_GLYPHS; i++)
+	{
+		const size_t glyph = charset.find((char)std::toupper((unsigned char)text[i]));
+		mOverlayUniforms.glyphs[glyphCount++] = glm::vec4(x + i * advance, y, glyph == std::string::npos ? 0 : glyph, 0.0f);
 	}
+	return glyphCount;
 }
@@ -7,12 +7,59 @@
 
 #include <vector>
 #include <memory>
-#include <map>
+#include <string>
+#include <unordered_map>
 #include "ShaderProgram.hpp"
-#include "MeshData.hpp"
+#include "MeshLoader.hpp"
+#include "RenderQueue.hpp"
+#include "MaterialTable.hpp"
+#include "TextureLoader.hpp"
+#include "Profiler.hpp"
+#include "SimulationPipeline.hpp"
+#include "CommandList.hpp"
+#include "JobSystem.hpp"
+#include "ShadowAtlas.hpp"
+#include "CascadedShadowMaps.hpp"
+#include "ShaderPermutations.hpp"
+#include "GLStateCache.hpp"
+#include "RenderStats.hpp"
+#include "MemoryTracker.hpp"
 
 #define MAX_LIGHT_COUNT 32
+#define MAX_DIRECTIONAL_LIGHT_COUNT 4
 #define MAX_INSTANCE_COUNT 64
+#define SHADER_CACHE_PATH "shader_cache.bin"
+#define TEXTURE_UPLOAD_BUDGET (4 * 1024 * 1024)
+#define MESH_UPLOAD_BUDGET (4 * 1024 * 1024)
+#define MESH_JOBS_PER_THREAD 4
+#define MESH_LOD_PIXEL_ERROR 1.0f
+#define MESHLET_MERGE_GAP 2
+#define SHADOW_NEAR_PLANE_RATIO 0.01f
+#define SHADOW_FOV_MARGIN_DEGREES 5.0f
+#define SHADOW_DEPTH_BIAS_FACTOR 2.0f
+#define SHADOW_DEPTH_BIAS_UNITS 4.0f
+#define MAX_OVERLAY_GLYPHS 512
+#define OVERLAY_GLYPH_SCALE 3.0f
+// The characters of the overlay font in the order of its glyphs, anything else is drawn as a space.
+#define OVERLAY_CHARSET " 0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ:./-%|()"
+
+
+//----------------------Enumerations----------------------
+
+// Multi pass blends every light in its own pass over the ambient pass, forward shades all the lights at once.
+enum class ShadingMode
+{
+	MultiPass,
+	Forward
+};
+
+
+// The cube is drawn first without depth testing, the triangle last on the far plane so only visible sky is shaded.
+enum class SkyboxMode
+{
+	Cube,
+	FullscreenTriangle
+};
 
 
 //----------------------Structures----------------------
@@ -22,7 +69,10 @@ struct DirectionalLight
 	glm::vec3 direction;
 	float PADDING1;
 	glm::vec3 intensity;
-	float PADDING2;
+	int castShadow;
+	int firstLayer;
+	int PADDING2[3];
+	glm::mat4 cascadeXforms[CSM_CASCADE_COUNT];
 };
 
 struct PointLight
@@ -40,17 +90,26 @@ struct SpotLight
 	glm::vec3 intensity;
 	float angle;
 	glm::vec3 direction;
-	float PADDING0;
+	int castShadow;
+	glm::mat4 shadowXform;
+};
+
+// The per frame values every command building job reads.
+struct FrameView
+{
+	glm::mat4 viewProjection;
+	glm::vec3 cameraPos;
+	glm::vec3 cameraDir;
+	float farPlane;
+	float lodScale;
+	GLuint texture;
+	glm::vec4 frustumPlanes[6];
 };
 
-struct InstanceData
+// The top three rows of an instance's model xform, the view projection is applied in the vertex shader.
+struct InstanceXform
 {
-	glm::mat4 mvpXform;
-	glm::mat4 modelXform;
-	glm::vec3 diffuse;
-	float shininess;
-	glm::vec3 specular;
-	int isShiny;
+	glm::vec4 rows[3];
 };
 
 
@@ -58,14 +117,18 @@ struct InstanceData
 
 struct PerFrameUniforms
 {
+	glm::mat4 viewProjectionXform;
 	glm::vec3 cameraPos;
 	float PADDING0;
 	glm::vec3 ambientIntensity;
 };
 
+// The xforms and material indices are separate arrays, so a draw uploads two contiguous ranges of 52 bytes
+// per instance in total.
 struct PerModelUniforms
 {
-	InstanceData instances[MAX_INSTANCE_COUNT];
+	InstanceXform xforms[MAX_INSTANCE_COUNT];
+	int materialIndices[MAX_INSTANCE_COUNT];
 };
 
 struct DirectionalLightUniforms
@@ -83,50 +146,189 @@ struct SpotLightUniforms
 	SpotLight light;
 };
 
+struct LightArrayUniforms
+{
+	int directionalLightCount;
+	int pointLightCount;
+	int spotLightCount;
+	int PADDING0;
+	DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHT_COUNT];
+	PointLight pointLights[MAX_LIGHT_COUNT];
+	SpotLight spotLights[MAX_LIGHT_COUNT];
+};
+
+struct ShadowUniforms
+{
+	glm::mat4 lightViewProjectionXform;
+};
+
 struct SkyboxUniforms
 {
 	glm::mat4 viewProjectionXform;
 	glm::vec3 cameraPos;
 };
 
+struct SkyboxTriangleUniforms
+{
+	glm::mat4 inverseViewProjectionXform;
+	glm::vec3 cameraPos;
+};
+
+// Each glyph is the pixel position of its top left corner and its index in OVERLAY_CHARSET.
+struct OverlayUniforms
+{
+	glm::vec2 screenSize;
+	float glyphScale;
+	float PADDING0;
+	glm::vec4 glyphs[MAX_OVERLAY_GLYPHS];
+};
+
 
 //----------------------MyView----------------------
 
 class MyView : public tygra::WindowViewDelegate
 {
+	// The benchmark drives the view directly to render into its own framebuffer.
+	friend class Benchmark;
+
 public:
     MyView();
     ~MyView();
 
     void setScene(const sponza::Context * sponza);
+	void SetSnapshot(const SceneSnapshot* snapshot);
 	void ToggleSkybox();
+	void SetSkyboxEnabled(bool enabled);
+	void ToggleSkyboxMode();
+	void SetSkyboxMode(SkyboxMode mode);
+	void ToggleShadingMode();
+	void SetShadingMode(ShadingMode mode);
+	void ToggleShaderVariants();
+	void SetShaderVariantsEnabled(bool enabled);
+	void ToggleStatsOverlay();
+	void SetStatsOverlayEnabled(bool enabled);
+	void SetMeshMemoryBudget(size_t bytes);
+	bool IsStreaming() const;
+
+	// Whether the mesh memory budget is holding back meshes, in which case streaming may never finish.
+	bool IsMeshBudgetLimited() const;
+	void PrintRenderStats() const;
+	void PrintProfile() const;
+	void PrintMemoryReport() const;
+	void WriteProfile() const;
+	void WriteRenderStats() const;
 
 private:
 	const sponza::Context * scene_;
+	const SceneSnapshot* mSnapshot = nullptr;
 
 	ShaderProgram mSkyboxShaderProgram;
+	ShaderProgram mSkyboxTriangleShaderProgram;
 	ShaderProgram mAmbShaderProgram;
 	ShaderProgram mDirShaderProgram;
-	ShaderProgram mPointShaderProgram;
 	ShaderProgram mSpotShaderProgram;
+	ShaderProgram mShadowShaderProgram;
+	ShaderProgram mOverlayShaderProgram;
 
-	std::map<sponza::MeshId, MeshData> mMeshes;
-	std::map<std::string, GLuint> mTextures;
+	// The passes which shade specular have a program per variant, indexed by the variant's feature bits.
+	ShaderProgram mPointShaderPrograms[SHADER_VARIANT_COUNT];
+	ShaderProgram mForwardShaderPrograms[SHADER_VARIANT_COUNT];
+
+	// Dense registries indexed by handle, the sponza ids are only translated as each mesh is registered.
+	MeshLoader mMeshLoader;
+	std::unordered_map<sponza::InstanceId, int> mInstanceIndices;
+	std::vector<sponza::MeshId> mMeshIds;
+	std::vector<std::vector<int>> mMeshInstanceIndices;
+	std::vector<std::vector<int>> mMeshInstanceMaterials;
+	std::vector<MeshRequest> mMeshRequests;
+	MaterialTable mMaterials;
+	TextureLoader mTextureLoader;
 
 	bool mRenderSkybox = false;
+	SkyboxMode mSkyboxMode = SkyboxMode::FullscreenTriangle;
+	ShadingMode mShadingMode = ShadingMode::MultiPass;
+	bool mUseShaderVariants = true;
+	bool mShowStatsOverlay = false;
 	
-	GLuint mSkyboxTexture;
+	TextureHandle mSkyboxTexture = INVALID_TEXTURE_HANDLE;
 	GLuint mSkyboxPositionVBO;
 	GLuint mSkyboxVAO;
+	GLuint mSkyboxTriangleVAO;
+	GLuint mOverlayVAO;
+	OverlayUniforms mOverlayUniforms;
+
+	struct InstanceOrder
+	{
+		int lod;
+		uint32_t variant;
+		float depth;
+		int index;
+	};
+
+	// What a spot light's cached shadow was rendered with, so a static light knows when to render it again.
+	struct SpotShadowState
+	{
+		glm::vec3 position;
+		glm::vec3 direction;
+		float angle = 0.0f;
+		float range = 0.0f;
+	};
+
+	struct FrameJob
+	{
+		CommandList commands;
+		std::vector<InstanceOrder> instanceOrder;
+		size_t triangleCount;
+		size_t fullDetailTriangleCount;
+		size_t meshletCount;
+		size_t visibleMeshletCount;
+	};
 
 	std::vector<PerModelUniforms> perModelUniforms;
+	std::vector<DirectionalLightUniforms> mDirectionalLightUniforms;
+	std::vector<PointLightUniforms> mPointLightUniforms;
+	std::vector<SpotLightUniforms> mSpotLightUniforms;
+	LightArrayUniforms mLightArrayUniforms;
+	std::vector<FrameJob> mFrameJobs;
+	size_t mTriangleCount = 0;
+	size_t mFullDetailTriangleCount = 0;
+	size_t mMeshletCount = 0;
+	size_t mVisibleMeshletCount = 0;
+	RenderQueue mRenderQueue;
+	ShadowAtlas mShadowAtlas;
+	CascadedShadowMaps mCascadedShadowMaps;
+	PerModelUniforms mShadowInstances;
+	std::vector<SpotShadowState> mSpotShadowStates;
+	std::vector<glm::mat4> mPreviousInstanceXforms;
+	size_t mShadowResidentCount = 0;
+	int mShadowRenderCount = 0;
+	int mShadowTileCount = 0;
+	int mCascadeRenderCount = 0;
+	int mVariantDrawCounts[SHADER_VARIANT_COUNT] = {};
+	int mProgramSwitchCount = 0;
+	Profiler mProfiler;
 
     void windowViewWillStart(tygra::Window * window) override;
+	void BuildShaderPrograms();
     void windowViewDidReset(tygra::Window * window, int width, int height) override;
     void windowViewDidStop(tygra::Window * window) override;
     void windowViewRender(tygra::Window * window) override;	
-	void LoadTexture(std::string name);
-	void DrawMeshesInstanced(ShaderProgram& shaderProgram);
+	void RegisterMeshes();
+	void DrawSkybox(const glm::mat4& viewProjection, const glm::vec3& cameraPos);
+	void DrawMeshesInstanced(ShaderProgram& shaderProgram, RenderPass pass);
+	void DrawItems(ShaderProgram& shaderProgram, size_t first, size_t last, bool perVariantPrograms = false);
+	void UploadInstances(ShaderProgram& shaderProgram, const PerModelUniforms& uniforms, int firstInstance, int instanceCount);
+	void BuildMeshCommands(const SceneSnapshot& snapshot, const FrameView& frameView, int job, int jobCount);
+	void PushMeshletRanges(FrameJob& frameJob, const FrameView& frameView, const MeshData& mesh, const glm::mat4& xform,
+		DrawItem item, float depth);
+	void BuildLightUniforms(const SceneSnapshot& snapshot);
+	void RenderSpotShadows(const SceneSnapshot& snapshot, const FrameView& frameView, float viewportHeight);
+	void RenderDirectionalShadows(const SceneSnapshot& snapshot, const glm::mat4& view, float aspectRatio);
+	void DrawShadowCasters(const glm::vec4 lightFrustumPlanes[6]);
+	void BuildLightArrayUniforms();
+	void FinishFrame(const GLint viewportSize[4]);
+	void DrawStatsOverlay(int width, int height);
+	int PushOverlayText(int glyphCount, const std::string& text, float x, float y);
 };
 
 
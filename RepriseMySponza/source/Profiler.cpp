@@ -0,0 +1,307 @@
+#include "Profiler.hpp"
+
+#ifdef TDK_NVTX
+#include <nvToolsExt.h>
+#endif
+
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+
+Profiler::Profiler()
+{
+	mHistory.resize(PROFILER_HISTORY_SIZE);
+}
+
+
+Profiler::~Profiler()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void Profiler::Shutdown()
+{
+	// Deleting the queries, must be called while the GL context is still current.
+	for (auto& section : mSections)
+		glDeleteQueries(PROFILER_FRAME_LATENCY, section.queries.data());
+	mSections.clear();
+}
+
+void Profiler::BeginFrame()
+{
+	mFrameIndex++;
+	mFrameStart = std::chrono::steady_clock::now();
+
+	// Collecting the queries issued PROFILER_FRAME_LATENCY frames ago before their slot is reused.
+	ResolveQueries(mFrameIndex % PROFILER_FRAME_LATENCY);
+
+	ProfileFrame& frame = GetFrame(mFrameIndex);
+	frame.frameIndex = mFrameIndex;
+	frame.startMs = ToMs(mFrameStart);
+	frame.cpuMs = 0.0;
+	frame.samples.assign(mSections.size(), ProfileSample());
+
+#ifdef TDK_NVTX
+	nvtxRangePushA("Frame");
+#endif
+}
+
+void Profiler::EndFrame()
+{
+	GetFrame(mFrameIndex).cpuMs = ToMs(std::chrono::steady_clock::now()) - ToMs(mFrameStart);
+
+#ifdef TDK_NVTX
+	nvtxRangePop();
+#endif
+}
+
+void Profiler::BeginSection(const char* name)
+{
+	mActiveSection = FindSection(name);
+	Section& section = mSections[mActiveSection];
+
+	ProfileFrame& frame = GetFrame(mFrameIndex);
+	if (frame.samples.size() < mSections.size())
+		frame.samples.resize(mSections.size());
+
+#ifdef TDK_NVTX
+	nvtxRangePushA(name);
+#endif
+
+	// A section which runs twice in a frame is only timed on the GPU the first time.
+	const int slot = mFrameIndex % PROFILER_FRAME_LATENCY;
+	mGpuQueryActive = !(section.issued[slot] && section.frames[slot] == mFrameIndex);
+	if (mGpuQueryActive)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, section.queries[slot]);
+		section.issued[slot] = true;
+		section.frames[slot] = mFrameIndex;
+	}
+
+	mSectionStart = std::chrono::steady_clock::now();
+}
+
+void Profiler::EndSection()
+{
+	if (mActiveSection < 0) return;
+
+	const auto sectionEnd = std::chrono::steady_clock::now();
+	if (mGpuQueryActive)
+		glEndQuery(GL_TIME_ELAPSED);
+
+#ifdef TDK_NVTX
+	nvtxRangePop();
+#endif
+
+	// Accumulating the CPU time in case the section runs more than once.
+	ProfileSample& sample = GetFrame(mFrameIndex).samples[mActiveSection];
+	if (sample.cpuMs < 0.0)
+	{
+		sample.cpuStartMs = ToMs(mSectionStart);
+		sample.cpuMs = 0.0;
+	}
+	sample.cpuMs += std::chrono::duration<double, std::milli>(sectionEnd - mSectionStart).count();
+
+	mActiveSection = -1;
+	mGpuQueryActive = false;
+}
+
+size_t Profiler::GetSectionCount() const
+{
+	return mSections.size();
+}
+
+const std::string& Profiler::GetSectionName(size_t section) const
+{
+	return mSections[section].name;
+}
+
+double Profiler::GetAverageCpuMs(size_t section) const
+{
+	double total = 0.0;
+	int count = 0;
+	for (uint64_t i = 0; i < PROFILER_AVERAGE_FRAMES && i < mFrameIndex; i++)
+	{
+		const ProfileFrame* frame = FindFrame(mFrameIndex - i);
+		if (frame == nullptr || section >= frame->samples.size() || frame->samples[section].cpuMs < 0.0) continue;
+		total += frame->samples[section].cpuMs;
+		count++;
+	}
+	return count > 0 ? total / count : 0.0;
+}
+
+double Profiler::GetAverageGpuMs(size_t section) const
+{
+	double total = 0.0;
+	int count = 0;
+	for (uint64_t i = 0; i < PROFILER_AVERAGE_FRAMES && i < mFrameIndex; i++)
+	{
+		const ProfileFrame* frame = FindFrame(mFrameIndex - i);
+		if (frame == nullptr || section >= frame->samples.size() || frame->samples[section].gpuMs < 0.0) continue;
+		total += frame->samples[section].gpuMs;
+		count++;
+	}
+	return count > 0 ? total / count : 0.0;
+}
+
+double Profiler::GetAverageFrameMs() const
+{
+	// Skipping the current frame as it has not ended yet.
+	double total = 0.0;
+	int count = 0;
+	for (uint64_t i = 1; i <= PROFILER_AVERAGE_FRAMES && i < mFrameIndex; i++)
+	{
+		const ProfileFrame* frame = FindFrame(mFrameIndex - i);
+		if (frame == nullptr) continue;
+		total += frame->cpuMs;
+		count++;
+	}
+	return count > 0 ? total / count : 0.0;
+}
+
+void Profiler::PrintAverages() const
+{
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "Frame : " << GetAverageFrameMs() << " ms (CPU, last " << PROFILER_AVERAGE_FRAMES << " frames)" << std::endl;
+	for (size_t i = 0; i < mSections.size(); i++)
+	{
+		std::cout << "  " << std::left << std::setw(12) << mSections[i].name << std::right
+			<< " CPU : " << std::setw(8) << GetAverageCpuMs(i) << " ms"
+			<< " | GPU : " << std::setw(8) << GetAverageGpuMs(i) << " ms" << std::endl;
+	}
+}
+
+bool Profiler::WriteCsv(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) return false;
+
+	// One row per section per frame, times which are unavailable are left empty.
+	file << std::fixed << std::setprecision(4);
+	file << "frame,section,cpu_start_ms,cpu_ms,gpu_ms\n";
+	const uint64_t first = mFrameIndex >= PROFILER_HISTORY_SIZE ? mFrameIndex - PROFILER_HISTORY_SIZE + 1 : 1;
+	for (uint64_t frameIndex = first; frameIndex <= mFrameIndex; frameIndex++)
+	{
+		const ProfileFrame* frame = FindFrame(frameIndex);
+		if (frame == nullptr) continue;
+		for (size_t i = 0; i < frame->samples.size(); i++)
+		{
+			const ProfileSample& sample = frame->samples[i];
+			if (sample.cpuMs < 0.0) continue;
+			file << frameIndex << "," << mSections[i].name << "," << sample.cpuStartMs << "," << sample.cpuMs << ",";
+			if (sample.gpuMs >= 0.0) file << sample.gpuMs;
+			file << "\n";
+		}
+	}
+	return (bool)file;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file) return false;
+
+	// Writing the trace event format read by chrome://tracing, with the CPU and GPU as separate threads.
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+	file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+	const uint64_t first = mFrameIndex >= PROFILER_HISTORY_SIZE ? mFrameIndex - PROFILER_HISTORY_SIZE + 1 : 1;
+	for (uint64_t frameIndex = first; frameIndex <= mFrameIndex; frameIndex++)
+	{
+		const ProfileFrame* frame = FindFrame(frameIndex);
+		if (frame == nullptr) continue;
+
+		file << ",\n{\"name\":\"Frame " << frameIndex << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << frame->startMs * 1000.0
+			<< ",\"dur\":" << frame->cpuMs * 1000.0 << "}";
+
+		// GL_TIME_ELAPSED only gives durations, so the GPU sections are laid out back-to-back from the start of the frame.
+		double gpuCursorMs = frame->startMs;
+		for (size_t i = 0; i < frame->samples.size(); i++)
+		{
+			const ProfileSample& sample = frame->samples[i];
+			if (sample.cpuMs < 0.0) continue;
+			file << ",\n{\"name\":\"" << mSections[i].name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << sample.cpuStartMs * 1000.0
+				<< ",\"dur\":" << sample.cpuMs * 1000.0 << "}";
+			if (sample.gpuMs < 0.0) continue;
+			file << ",\n{\"name\":\"" << mSections[i].name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":" << gpuCursorMs * 1000.0
+				<< ",\"dur\":" << sample.gpuMs * 1000.0 << "}";
+			gpuCursorMs += sample.gpuMs;
+		}
+	}
+	file << "\n]}\n";
+	return (bool)file;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+int Profiler::FindSection(const char* name)
+{
+	for (size_t i = 0; i < mSections.size(); i++)
+		if (mSections[i].name == name) return i;
+
+	// Registering the section the first time it is seen.
+	Section section;
+	section.name = name;
+	glGenQueries(PROFILER_FRAME_LATENCY, section.queries.data());
+	section.issued.fill(false);
+	section.frames.fill(0);
+	mSections.push_back(section);
+	return mSections.size() - 1;
+}
+
+void Profiler::ResolveQueries(int slot)
+{
+	for (size_t i = 0; i < mSections.size(); i++)
+	{
+		Section& section = mSections[i];
+		if (!section.issued[slot]) continue;
+		section.issued[slot] = false;
+
+		// Dropping the sample rather than waiting if the GPU has not caught up yet.
+		GLint available = GL_FALSE;
+		glGetQueryObjectiv(section.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available == GL_FALSE) continue;
+
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(section.queries[slot], GL_QUERY_RESULT, &elapsedNs);
+		ProfileFrame& frame = GetFrame(section.frames[slot]);
+		if (frame.frameIndex == section.frames[slot] && i < frame.samples.size())
+			frame.samples[i].gpuMs = elapsedNs / 1000000.0;
+	}
+}
+
+ProfileFrame& Profiler::GetFrame(uint64_t frameIndex)
+{
+	return mHistory[frameIndex % PROFILER_HISTORY_SIZE];
+}
+
+const ProfileFrame* Profiler::FindFrame(uint64_t frameIndex) const
+{
+	const ProfileFrame& frame = mHistory[frameIndex % PROFILER_HISTORY_SIZE];
+	return frame.frameIndex == frameIndex ? &frame : nullptr;
+}
+
+double Profiler::ToMs(std::chrono::steady_clock::time_point time) const
+{
+	return std::chrono::duration<double, std::milli>(time - mStartTime).count();
+}
+
+
+//--------------------------------ProfileScope--------------------------------
+
+ProfileScope::ProfileScope(Profiler& profiler, const char* name) : mProfiler(profiler)
+{
+	mProfiler.BeginSection(name);
+}
+
+
+ProfileScope::~ProfileScope()
+{
+	mProfiler.EndSection();
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <tgl/tgl.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+
+#define PROFILER_FRAME_LATENCY 2
+#define PROFILER_HISTORY_SIZE 240
+#define PROFILER_AVERAGE_FRAMES 60
+
+
+//----------------------Structures----------------------
+
+struct ProfileSample
+{
+	double cpuStartMs = 0.0;
+	double cpuMs = -1.0;
+	double gpuMs = -1.0;
+};
+
+struct ProfileFrame
+{
+	uint64_t frameIndex = 0;
+	double startMs = 0.0;
+	double cpuMs = 0.0;
+	std::vector<ProfileSample> samples;
+};
+
+
+//----------------------Profiler----------------------
+
+// Times named sections of a frame on the CPU and, through GL_TIME_ELAPSED queries, on the GPU. The queries
+// are double-buffered and only read back once available, so collecting results never stalls the pipeline.
+// Sections also emit NVTX ranges when built with TDK_NVTX.
+class Profiler
+{
+public:
+	Profiler();
+	~Profiler();
+
+	void Shutdown();
+
+	void BeginFrame();
+	void EndFrame();
+
+	// Sections must not overlap as only one GL_TIME_ELAPSED query can be active at a time.
+	void BeginSection(const char* name);
+	void EndSection();
+
+	size_t GetSectionCount() const;
+	const std::string& GetSectionName(size_t section) const;
+
+	// Rolling averages over the last PROFILER_AVERAGE_FRAMES frames which ran the section.
+	double GetAverageCpuMs(size_t section) const;
+	double GetAverageGpuMs(size_t section) const;
+	double GetAverageFrameMs() const;
+	void PrintAverages() const;
+
+	bool WriteCsv(const std::string& path) const;
+	bool WriteChromeTrace(const std::string& path) const;
+
+private:
+	struct Section
+	{
+		std::string name;
+		std::array<GLuint, PROFILER_FRAME_LATENCY> queries;
+		std::array<bool, PROFILER_FRAME_LATENCY> issued;
+		std::array<uint64_t, PROFILER_FRAME_LATENCY> frames;
+	};
+
+	std::vector<Section> mSections;
+	std::vector<ProfileFrame> mHistory;
+	uint64_t mFrameIndex = 0;
+	int mActiveSection = -1;
+	bool mGpuQueryActive = false;
+	std::chrono::steady_clock::time_point mStartTime = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point mSectionStart;
+	std::chrono::steady_clock::time_point mFrameStart;
+
+	int FindSection(const char* name);
+	void ResolveQueries(int slot);
+	ProfileFrame& GetFrame(uint64_t frameIndex);
+	const ProfileFrame* FindFrame(uint64_t frameIndex) const;
+	double ToMs(std::chrono::steady_clock::time_point time) const;
+};
+
+
+//----------------------ProfileScope----------------------
+
+// Times the enclosing block as a section of the profiler.
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler& profiler, const char* name);
+	~ProfileScope();
+
+private:
+	Profiler& mProfiler;
+};
@@ -0,0 +1,131 @@
+#include "ProgramBinaryCache.hpp"
+
+#include <fstream>
+
+
+ProgramBinaryCache::ProgramBinaryCache()
+{
+}
+
+
+ProgramBinaryCache::~ProgramBinaryCache()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+bool ProgramBinaryCache::Load(const std::string& path)
+{
+	mEntries.clear();
+	mDriver = std::string((const char*)glGetString(GL_VENDOR)) + "|" + (const char*)glGetString(GL_RENDERER) + "|"
+		+ (const char*)glGetString(GL_VERSION);
+	if (!IsSupported()) return false;
+
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) return false;
+	const std::streamoff fileSize = file.tellg();
+	file.seekg(0);
+
+	// Reading the version and entry count, then each entry's key, format, length and binary.
+	uint32_t version = 0;
+	uint32_t entryCount = 0;
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&entryCount, sizeof(entryCount));
+	if (!file || version != PROGRAM_BINARY_CACHE_VERSION) return false;
+
+	// A truncated or corrupt file is discarded whole, its lengths are checked against what is left before anything
+	// is allocated for them.
+	for (uint32_t i = 0; i < entryCount; i++)
+	{
+		uint64_t key = 0;
+		uint32_t length = 0;
+		Entry entry;
+		file.read((char*)&key, sizeof(key));
+		file.read((char*)&entry.format, sizeof(entry.format));
+		file.read((char*)&length, sizeof(length));
+		if (!file || length == 0 || length > fileSize - (std::streamoff)file.tellg())
+		{
+			mEntries.clear();
+			return false;
+		}
+		entry.binary.resize(length);
+		file.read(entry.binary.data(), length);
+		if (!file)
+		{
+			mEntries.clear();
+			return false;
+		}
+		mEntries[key] = std::move(entry);
+	}
+	return true;
+}
+
+bool ProgramBinaryCache::Save(const std::string& path) const
+{
+	if (!IsSupported()) return false;
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file) return false;
+
+	uint32_t version = PROGRAM_BINARY_CACHE_VERSION;
+	uint32_t entryCount = 0;
+	for (const auto& entry : mEntries)
+		entryCount += entry.second.used ? 1 : 0;
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&entryCount, sizeof(entryCount));
+
+	for (const auto& entry : mEntries)
+	{
+		if (!entry.second.used) continue;
+		const uint32_t length = entry.second.binary.size();
+		file.write((const char*)&entry.first, sizeof(entry.first));
+		file.write((const char*)&entry.second.format, sizeof(entry.second.format));
+		file.write((const char*)&length, sizeof(length));
+		file.write(entry.second.binary.data(), length);
+	}
+	return (bool)file;
+}
+
+bool ProgramBinaryCache::IsSupported()
+{
+	if (glGetProgramBinary == nullptr || glProgramBinary == nullptr || glProgramParameteri == nullptr) return false;
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(const std::string& vertexSource, const std::string& fragmentSource) const
+{
+	// Hashing with 64 bit FNV-1a, separating the strings so moving text between them changes the key.
+	uint64_t hash = 14695981039346656037ull;
+	for (const std::string* text : { &vertexSource, &fragmentSource, &mDriver })
+	{
+		for (char character : *text)
+			hash = (hash ^ (unsigned char)character) * 1099511628211ull;
+		hash = (hash ^ 0xff) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool ProgramBinaryCache::Restore(uint64_t key, GLuint program)
+{
+	auto entry = mEntries.find(key);
+	if (entry == mEntries.end()) return false;
+
+	glProgramBinary(program, entry->second.format, entry->second.binary.data(), entry->second.binary.size());
+	entry->second.used = true;
+	return true;
+}
+
+void ProgramBinaryCache::Store(uint64_t key, GLuint program)
+{
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+
+	Entry& entry = mEntries[key];
+	entry.binary.resize(length);
+	glGetProgramBinary(program, length, nullptr, &entry.format, entry.binary.data());
+	entry.used = true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <tgl/tgl.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Program binaries are core in GL 4.1, above the GL 3.3 tgl declares for this project, but tgl loads the
+// entry points whenever the driver provides them, so they are declared here along with their enums.
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern "C" PFNGLGETPROGRAMBINARYPROC glGetProgramBinary;
+extern "C" PFNGLPROGRAMBINARYPROC glProgramBinary;
+extern "C" PFNGLPROGRAMPARAMETERIPROC glProgramParameteri;
+#endif
+
+#define PROGRAM_BINARY_CACHE_VERSION 1
+
+
+//----------------------ProgramBinaryCache----------------------
+
+// Linked program binaries kept on disk between runs. Entries are keyed on a hash of the shader sources and
+// the driver's vendor, renderer and version strings, so a driver update or an edited shader misses the
+// cache and compiles from source instead. Only the entries used in a run are saved, which drops stale ones.
+class ProgramBinaryCache
+{
+public:
+	ProgramBinaryCache();
+	~ProgramBinaryCache();
+
+	// Both return false when the driver cannot provide binaries or the file cannot be used, which only costs
+	// compiling from source.
+	bool Load(const std::string& path);
+	bool Save(const std::string& path) const;
+
+	static bool IsSupported();
+	uint64_t MakeKey(const std::string& vertexSource, const std::string& fragmentSource) const;
+
+	// Loads the binary for 'key' into 'program', which still has to be checked for a successful link.
+	bool Restore(uint64_t key, GLuint program);
+	void Store(uint64_t key, GLuint program);
+
+private:
+	struct Entry
+	{
+		GLenum format = 0;
+		std::vector<char> binary;
+		bool used = false;
+	};
+
+	std::unordered_map<uint64_t, Entry> mEntries;
+	std::string mDriver;
+};
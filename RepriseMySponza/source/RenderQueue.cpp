@@ -0,0 +1,186 @@
+#include "RenderQueue.hpp"
+#include "GLStateCache.hpp"
+#include <glm/glm.hpp>
+#include <cassert>
+
+
+//----------------------Sort Key Layout----------------------
+
+// Opaque pass   : [pass:4][program:8][depth:24][texture:12][vao:16]
+// Lighting pass : [pass:4][program:8][texture:12][vao:16][depth:24]
+// Depth writing passes are sorted front-to-back within each shader variant so that early-Z can reject hidden
+// fragments without switching programs between every draw, whereas the additive lighting passes test against
+// the existing depth buffer so they are sorted by state to minimise binds.
+
+static const int PASS_BITS = 4;
+static const int DEPTH_BITS = 24;
+static const int PROGRAM_BITS = 8;
+static const int TEXTURE_BITS = 12;
+static const int VAO_BITS = 16;
+
+
+RenderQueue::RenderQueue()
+{
+}
+
+
+RenderQueue::~RenderQueue()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void RenderQueue::Clear()
+{
+	mItems.clear();
+}
+
+void RenderQueue::Push(RenderPass pass, int program, GLuint texture, GLuint vao, float depth, DrawItem item)
+{
+	item.sortKey = MakeSortKey(pass, program, texture, vao, depth);
+	item.program = program;
+	item.texture = texture;
+	item.vao = vao;
+	mItems.push_back(item);
+}
+
+void RenderQueue::Append(const std::vector<DrawItem>& items)
+{
+	// The items already carry their sort keys.
+	mItems.insert(mItems.end(), items.begin(), items.end());
+}
+
+void RenderQueue::Sort()
+{
+	// Charging each item the binds that differ from the previous item of its pass in submission order, the first
+	// item of a pass binds its texture and VAO.
+	const DrawItem* previous[1 << PASS_BITS] = { nullptr };
+	for (auto& item : mItems)
+	{
+		const DrawItem*& passPrevious = previous[item.sortKey >> (64 - PASS_BITS)];
+		item.naiveFirstOfPass = passPrevious == nullptr;
+		item.naiveVariantChange = passPrevious != nullptr && item.program != passPrevious->program;
+		item.naiveStateChanges = passPrevious == nullptr ? 2 : (item.texture != passPrevious->texture ? 1 : 0)
+			+ (item.vao != passPrevious->vao ? 1 : 0);
+		passPrevious = &item;
+	}
+
+	RadixSort();
+}
+
+void RenderQueue::GetPassRange(RenderPass pass, size_t& first, size_t& last) const
+{
+	// The items are sorted so each pass is a contiguous run.
+	const uint64_t passBits = (uint64_t)pass;
+	first = 0;
+	while (first < mItems.size() && (mItems[first].sortKey >> (64 - PASS_BITS)) < passBits) first++;
+	last = first;
+	while (last < mItems.size() && (mItems[last].sortKey >> (64 - PASS_BITS)) == passBits) last++;
+}
+
+void RenderQueue::GetProgramRange(RenderPass pass, int program, size_t& first, size_t& last) const
+{
+	size_t passLast;
+	GetPassRange(pass, first, passLast);
+	while (first < passLast && mItems[first].program < program) first++;
+	last = first;
+	while (last < passLast && mItems[last].program == program) last++;
+}
+
+const DrawItem& RenderQueue::GetItem(size_t index) const
+{
+	return mItems[index];
+}
+
+void RenderQueue::BindItemState(const DrawItem& item, bool perVariantPrograms)
+{
+	mCurrentStats.naiveStateChanges += item.naiveStateChanges;
+	mCurrentStats.drawCount++;
+
+	// The caller binds the program, which only counts when it differs from the one the previous item was drawn with.
+	// Unsorted, a pass enters its program the same way but switches again at every change of variant in between.
+	GLStateCache& glState = GLStateCache::Instance();
+	const bool programChanged = glState.GetProgram() != mDrawnProgram;
+	if (item.naiveFirstOfPass ? programChanged : perVariantPrograms && item.naiveVariantChange)
+		mCurrentStats.naiveStateChanges++;
+	if (programChanged)
+	{
+		mDrawnProgram = glState.GetProgram();
+		mCurrentStats.stateChanges++;
+	}
+
+	if (glState.BindTexture(0, GL_TEXTURE_2D_ARRAY, item.texture))
+		mCurrentStats.stateChanges++;
+	if (glState.BindVertexArray(item.vao))
+		mCurrentStats.stateChanges++;
+}
+
+void RenderQueue::BeginFrame()
+{
+	mLastFrameStats = mCurrentStats;
+	mCurrentStats = RenderQueueStats();
+	mDrawnProgram = 0;
+}
+
+const RenderQueueStats& RenderQueue::GetLastFrameStats() const
+{
+	return mLastFrameStats;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+uint64_t RenderQueue::MakeSortKey(RenderPass pass, int program, GLuint texture, GLuint vao, float depth)
+{
+	// Quantizing the normalised view depth.
+	const uint64_t depthBits = (uint64_t)(glm::clamp(depth, 0.f, 1.f) * ((1 << DEPTH_BITS) - 1));
+	const uint64_t programBits = (uint64_t)program & ((1 << PROGRAM_BITS) - 1);
+	const uint64_t textureBits = (uint64_t)texture & ((1 << TEXTURE_BITS) - 1);
+	const uint64_t vaoBits = (uint64_t)vao & ((1 << VAO_BITS) - 1);
+
+	uint64_t key = (uint64_t)pass << (64 - PASS_BITS);
+	if (pass == RenderPass::Opaque)
+	{
+		key |= programBits << (DEPTH_BITS + TEXTURE_BITS + VAO_BITS);
+		key |= depthBits << (TEXTURE_BITS + VAO_BITS);
+		key |= textureBits << VAO_BITS;
+		key |= vaoBits;
+	}
+	else
+	{
+		key |= programBits << (TEXTURE_BITS + VAO_BITS + DEPTH_BITS);
+		key |= textureBits << (VAO_BITS + DEPTH_BITS);
+		key |= vaoBits << DEPTH_BITS;
+		key |= depthBits;
+	}
+	return key;
+}
+
+void RenderQueue::RadixSort()
+{
+	// LSD radix sort on the 64 bit keys, one byte per pass.
+	mSortScratch.resize(mItems.size());
+	for (int shift = 0; shift < 64; shift += 8)
+	{
+		size_t counts[256] = { 0 };
+		for (const auto& item : mItems)
+			counts[(item.sortKey >> shift) & 0xFF]++;
+
+		// Skipping the pass if every key shares this digit.
+		if (counts[(mItems.empty() ? 0 : (mItems[0].sortKey >> shift) & 0xFF)] == mItems.size()) continue;
+
+		size_t offset = 0;
+		for (auto& count : counts)
+		{
+			const size_t c = count;
+			count = offset;
+			offset += c;
+		}
+
+		for (const auto& item : mItems)
+			mSortScratch[counts[(item.sortKey >> shift) & 0xFF]++] = item;
+
+		mItems.swap(mSortScratch);
+	}
+}
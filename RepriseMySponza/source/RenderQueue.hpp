@@ -0,0 +1,88 @@
+#pragma once
+
+#include <tgl/tgl.h>
+#include <cstdint>
+#include <vector>
+
+
+//----------------------Enumerations----------------------
+
+// The passes are ordered as they are rendered, as the pass occupies the most significant bits of the sort key.
+enum class RenderPass : uint8_t
+{
+	Opaque = 0,
+	Lighting = 1
+};
+
+
+//----------------------Structures----------------------
+
+struct DrawItem
+{
+	uint64_t sortKey;
+
+	// The shader variant the item is drawn with, where the pass's program has variants.
+	int program;
+	GLuint vao;
+	GLuint texture;
+	int firstElement;
+	int elementCount;
+	int firstInstance;
+	int instanceCount;
+	int uniformIndex;
+
+	// The texture and VAO binds the item costs drawn in submission order, and whether it is the first item of its
+	// pass or changes shader variant from the item before it, set when the queue is sorted.
+	int naiveStateChanges;
+	bool naiveFirstOfPass;
+	bool naiveVariantChange;
+};
+
+struct RenderQueueStats
+{
+	int drawCount = 0;
+	int stateChanges = 0;
+	int naiveStateChanges = 0;
+};
+
+
+//----------------------RenderQueue----------------------
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+	~RenderQueue();
+
+	void Clear();
+	void Push(RenderPass pass, int program, GLuint texture, GLuint vao, float depth, DrawItem item);
+	void Append(const std::vector<DrawItem>& items);
+	void Sort();
+
+	// Returns the index range [first, last) of the sorted items that belong to a pass.
+	void GetPassRange(RenderPass pass, size_t& first, size_t& last) const;
+
+	// Narrows a pass's range to the items of one program, which are contiguous as the program follows the pass.
+	void GetProgramRange(RenderPass pass, int program, size_t& first, size_t& last) const;
+	const DrawItem& GetItem(size_t index) const;
+
+	// Binds the texture and VAO of an item through the state cache, which skips any that are already bound, and
+	// counts them and any change of the caller's program against the binds the same draws would make unsorted.
+	// 'perVariantPrograms' tells whether the caller draws each shader variant with its own program.
+	void BindItemState(const DrawItem& item, bool perVariantPrograms);
+
+	void BeginFrame();
+	const RenderQueueStats& GetLastFrameStats() const;
+
+	static uint64_t MakeSortKey(RenderPass pass, int program, GLuint texture, GLuint vao, float depth);
+
+private:
+	std::vector<DrawItem> mItems;
+	std::vector<DrawItem> mSortScratch;
+
+	RenderQueueStats mCurrentStats;
+	RenderQueueStats mLastFrameStats;
+	GLuint mDrawnProgram = 0;
+
+	void RadixSort();
+};
@@ -0,0 +1,140 @@
+#include "RenderStats.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <iomanip>
+
+
+//----------------------Counter Names----------------------
+
+// Written to the JSON dump, so renaming one breaks comparisons with older dumps.
+static const char* const COUNTER_NAMES[(size_t)RenderCounter::Count] =
+{
+	"draw_calls",
+	"instances_drawn",
+	"triangles_submitted",
+	"program_switches",
+	"uniform_bytes_uploaded",
+	"texture_bytes_uploaded",
+	"mesh_bytes_uploaded"
+};
+
+
+RenderStats::RenderStats()
+{
+}
+
+
+RenderStats::~RenderStats()
+{
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+RenderStats& RenderStats::Instance()
+{
+	static RenderStats instance;
+	return instance;
+}
+
+void RenderStats::Add(RenderCounter counter, uint64_t value)
+{
+	if (mPaused) return;
+	mCurrent[(size_t)counter] += value;
+}
+
+void RenderStats::AddDraw(uint64_t instanceCount, uint64_t triangleCount)
+{
+	if (mPaused) return;
+	mCurrent[(size_t)RenderCounter::DrawCalls]++;
+	mCurrent[(size_t)RenderCounter::InstancesDrawn] += instanceCount;
+	mCurrent[(size_t)RenderCounter::TrianglesSubmitted] += instanceCount * triangleCount;
+}
+
+void RenderStats::EndFrame()
+{
+	mHistory[mFrameCount % RENDER_STATS_AVERAGE_FRAMES] = mCurrent;
+	mCurrent.fill(0);
+	mFrameCount++;
+}
+
+uint64_t RenderStats::GetLastFrame(RenderCounter counter) const
+{
+	if (mFrameCount == 0) return 0;
+	return mHistory[(mFrameCount - 1) % RENDER_STATS_AVERAGE_FRAMES][(size_t)counter];
+}
+
+double RenderStats::GetAverage(RenderCounter counter) const
+{
+	// Averaging over the frames recorded so far until the history has filled.
+	const uint64_t frames = std::min<uint64_t>(mFrameCount, RENDER_STATS_AVERAGE_FRAMES);
+	if (frames == 0) return 0.0;
+	uint64_t total = 0;
+	for (uint64_t i = 0; i < frames; i++)
+		total += mHistory[i][(size_t)counter];
+	return total / (double)frames;
+}
+
+uint64_t RenderStats::GetFrameCount() const
+{
+	return mFrameCount;
+}
+
+const char* RenderStats::GetCounterName(RenderCounter counter)
+{
+	return COUNTER_NAMES[(size_t)counter];
+}
+
+void RenderStats::SetPaused(bool paused)
+{
+	mPaused = paused;
+}
+
+void RenderStats::Reset()
+{
+	mCurrent.fill(0);
+	for (auto& frame : mHistory)
+		frame.fill(0);
+	mFrameCount = 0;
+}
+
+bool RenderStats::WriteJson(const std::string& path, const std::string& label) const
+{
+	std::ofstream file(path);
+	if (!file) return false;
+	WriteJson(file, label);
+	return (bool)file;
+}
+
+void RenderStats::WriteJson(std::ostream& file, const std::string& label,
+	const std::vector<std::pair<std::string, std::string>>& fields) const
+{
+	file << std::fixed << std::setprecision(2);
+	file << "{\n";
+	file << "\t\"label\": \"" << label << "\",\n";
+	for (const auto& field : fields)
+		file << "\t\"" << field.first << "\": " << field.second << ",\n";
+	file << "\t\"frames\": " << mFrameCount << ",\n";
+	file << "\t\"average_frames\": " << std::min<uint64_t>(mFrameCount, RENDER_STATS_AVERAGE_FRAMES) << ",\n";
+	const auto writeCounters = [&](const char* name, bool average)
+	{
+		file << "\t\"" << name << "\": {\n";
+		for (size_t i = 0; i < (size_t)RenderCounter::Count; i++)
+		{
+			const RenderCounter counter = (RenderCounter)i;
+			file << "\t\t\"" << COUNTER_NAMES[i] << "\": ";
+			if (average)
+				file << GetAverage(counter);
+			else
+				file << GetLastFrame(counter);
+			file << (i + 1 < (size_t)RenderCounter::Count ? ",\n" : "\n");
+		}
+		file << "\t}";
+	};
+	writeCounters("last_frame", false);
+	file << ",\n";
+	writeCounters("average", true);
+	file << "\n}";
+}
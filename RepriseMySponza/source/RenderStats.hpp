@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <array>
+#include <vector>
+#include <utility>
+#include <iosfwd>
+
+#define RENDER_STATS_AVERAGE_FRAMES 60
+
+
+//----------------------Enumerations----------------------
+
+enum class RenderCounter
+{
+	DrawCalls,
+	InstancesDrawn,
+	TrianglesSubmitted,
+	ProgramSwitches,
+	UniformBytesUploaded,
+	TextureBytesUploaded,
+	MeshBytesUploaded,
+	Count
+};
+
+
+//----------------------RenderStats----------------------
+
+// Per frame counters of the work submitted to GL, kept for the last RENDER_STATS_AVERAGE_FRAMES frames so that
+// rolling averages can be shown on screen or dumped for comparison between builds. Only the GL thread counts.
+class RenderStats
+{
+public:
+	static RenderStats& Instance();
+
+	void Add(RenderCounter counter, uint64_t value = 1);
+	// Counts one instanced draw call of 'triangleCount' triangles per instance.
+	void AddDraw(uint64_t instanceCount, uint64_t triangleCount);
+	void EndFrame();
+	void Reset();
+
+	// Ignores everything counted while paused, so the overlay drawing the counters does not show up in them.
+	void SetPaused(bool paused);
+
+	uint64_t GetLastFrame(RenderCounter counter) const;
+	double GetAverage(RenderCounter counter) const;
+	uint64_t GetFrameCount() const;
+	static const char* GetCounterName(RenderCounter counter);
+
+	// Writes the last frame and the averages as a JSON object, 'label' naming the run. Each of 'fields' is written
+	// as another member, its value already formatted as JSON.
+	bool WriteJson(const std::string& path, const std::string& label) const;
+	void WriteJson(std::ostream& stream, const std::string& label,
+		const std::vector<std::pair<std::string, std::string>>& fields = {}) const;
+
+private:
+	typedef std::array<uint64_t, (size_t)RenderCounter::Count> FrameCounters;
+
+	RenderStats();
+	~RenderStats();
+
+	FrameCounters mCurrent = {};
+	std::array<FrameCounters, RENDER_STATS_AVERAGE_FRAMES> mHistory = {};
+	uint64_t mFrameCount = 0;
+	bool mPaused = false;
+};
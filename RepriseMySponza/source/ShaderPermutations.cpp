@@ -0,0 +1,56 @@
+#include "ShaderPermutations.hpp"
+#include "MyView.hpp"
+
+#include <sstream>
+
+
+//----------------------Feature Names----------------------
+
+static const char* const FEATURE_NAMES[SHADER_FEATURE_COUNT] =
+{
+	"SHADER_FEATURE_SPECULAR"
+};
+
+static const char* const FEATURE_LABELS[SHADER_FEATURE_COUNT] =
+{
+	"specular"
+};
+
+
+//--------------------------------Public Functions--------------------------------
+
+std::string ShaderPermutations::MakeDefines(uint32_t features)
+{
+	// The array sizes come from the C++ constants, so a uniform block can never disagree with its struct.
+	std::ostringstream defines;
+	defines << "#define MAX_INSTANCE_COUNT " << MAX_INSTANCE_COUNT << "\n";
+	defines << "#define MAX_MATERIAL_COUNT " << MAX_MATERIAL_COUNT << "\n";
+	defines << "#define MAX_LIGHT_COUNT " << MAX_LIGHT_COUNT << "\n";
+	defines << "#define MAX_DIRECTIONAL_LIGHT_COUNT " << MAX_DIRECTIONAL_LIGHT_COUNT << "\n";
+	defines << "#define CSM_CASCADE_COUNT " << CSM_CASCADE_COUNT << "\n";
+	defines << "#define MAX_OVERLAY_GLYPHS " << MAX_OVERLAY_GLYPHS << "\n";
+	for (int feature = 0; feature < SHADER_FEATURE_COUNT; feature++)
+		defines << "#define " << FEATURE_NAMES[feature] << " " << ((features >> feature) & 1) << "\n";
+	return defines.str();
+}
+
+uint32_t ShaderPermutations::GetMaterialFeatures(const MaterialData& material)
+{
+	// Matching the test the shaders made at run time before they were specialized.
+	uint32_t features = 0;
+	if (material.isShiny == 1 && material.shininess > 0.0f)
+		features |= SHADER_FEATURE_SPECULAR;
+	return features;
+}
+
+std::string ShaderPermutations::GetVariantName(uint32_t features)
+{
+	std::string name;
+	for (int feature = 0; feature < SHADER_FEATURE_COUNT; feature++)
+	{
+		if ((features & (1 << feature)) == 0) continue;
+		if (!name.empty()) name += "+";
+		name += FEATURE_LABELS[feature];
+	}
+	return name.empty() ? "base" : name;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "MaterialTable.hpp"
+
+#include <cstdint>
+#include <string>
+
+// The features a shader variant is specialized on. Each bit is passed to GLSL as a '#define' of the same name
+// set to 0 or 1, so the shaders test them with '#if' and a disabled feature costs nothing at run time. Only the
+// point light term tests a feature, so only the point and forward passes build a program per variant, the
+// ambient, directional and spot shaders are the same for every variant and are built once.
+#define SHADER_FEATURE_SPECULAR (1 << 0)
+#define SHADER_FEATURE_COUNT 1
+#define SHADER_VARIANT_COUNT (1 << SHADER_FEATURE_COUNT)
+
+// The variant with every feature, which can shade any material.
+#define SHADER_VARIANT_ALL (SHADER_VARIANT_COUNT - 1)
+
+namespace ShaderPermutations
+{
+	// The defines inserted after a shader's '#version' line, the shared array sizes followed by the feature bits.
+	std::string MakeDefines(uint32_t features);
+
+	// The cheapest variant able to shade a material.
+	uint32_t GetMaterialFeatures(const MaterialData& material);
+
+	// A readable list of a variant's features, for statistics.
+	std::string GetVariantName(uint32_t features);
+}
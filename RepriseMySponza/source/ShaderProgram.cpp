@@ -1,9 +1,18 @@
 #include "ShaderProgram.hpp"
+#include "GLStateCache.hpp"
+#include "RenderStats.hpp"
+#include "MemoryTracker.hpp"
 #include <tygra/FileHelper.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <vector>
 #include <iostream>
+#include <cstring>
+
+// The enum of KHR_parallel_shader_compile, which shares its values with ARB_parallel_shader_compile.
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 
 
@@ -14,6 +23,13 @@ ShaderProgram::ShaderProgram()
 
 ShaderProgram::~ShaderProgram()
 {
+	for (const auto& uniformBuffer : mOwnedUniformBufferSizes)
+	{
+		GLuint buffer = mUniformBuffers[uniformBuffer.first];
+		GLStateCache::Instance().ForgetBuffer(buffer);
+		glDeleteBuffers(1, &buffer);
+		MemoryTracker::Instance().Free(MemoryCategory::UniformBuffers, uniformBuffer.second);
+	}
 	glDeleteProgram(mProgramID);
 }
 
@@ -22,73 +38,199 @@ ShaderProgram::~ShaderProgram()
 
 void ShaderProgram::Use() const
 {
-	glUseProgram(mProgramID);
+	if (GLStateCache::Instance().UseProgram(mProgramID))
+		RenderStats::Instance().Add(RenderCounter::ProgramSwitches);
 }
 
-void ShaderProgram::Init(std::string vertexShaderPath, std::string fragmentShaderPath)
+void ShaderProgram::Init(std::string vertexShaderPath, std::string fragmentShaderPath, const std::string& defines,
+	const std::string& fragmentLibraryPath)
 {
-	// Load the shaders.
-	GLuint vertexShaderID = LoadShader(vertexShaderPath, GL_VERTEX_SHADER);
-	GLuint fragmentShaderID = LoadShader(fragmentShaderPath, GL_FRAGMENT_SHADER);
+	BeginInit(vertexShaderPath, fragmentShaderPath, defines, nullptr, fragmentLibraryPath);
+	FinishInit();
+}
 
-	// Link the shader program.
+void ShaderProgram::BeginInit(std::string vertexShaderPath, std::string fragmentShaderPath, const std::string& defines,
+	ProgramBinaryCache* cache, const std::string& fragmentLibraryPath)
+{
+	// Read the shader code from its files and specialize it, the result is also what the cache is keyed on.
+	mVertexShaderPath = vertexShaderPath;
+	mFragmentShaderPath = fragmentShaderPath;
+	mVertexSource = InsertDefines(tygra::createStringFromFile(vertexShaderPath), defines);
+	const std::string fragmentLibrary = fragmentLibraryPath.empty() ? "" : tygra::createStringFromFile(fragmentLibraryPath);
+	mFragmentSource = InsertDefines(tygra::createStringFromFile(fragmentShaderPath), defines, fragmentLibrary);
 	mProgramID = glCreateProgram();
-	glAttachShader(mProgramID, vertexShaderID);
-	glAttachShader(mProgramID, fragmentShaderID);
-	glLinkProgram(mProgramID);
 
-	// Check that the shader program linked correctly.
+	// Restore the linked program from the cache, or compile it from source.
+	mCache = cache != nullptr && ProgramBinaryCache::IsSupported() ? cache : nullptr;
+	mCached = false;
+	if (mCache != nullptr)
+	{
+		mCacheKey = mCache->MakeKey(mVertexSource, mFragmentSource);
+		mCached = mCache->Restore(mCacheKey, mProgramID);
+	}
+	if (!mCached)
+		CompileAndLink();
+}
+
+bool ShaderProgram::IsReady() const
+{
+	if (mCached || !HasParallelCompile()) return true;
+	GLint complete = GL_FALSE;
+	glGetProgramiv(mProgramID, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete == GL_TRUE;
+}
+
+void ShaderProgram::FinishInit()
+{
+	// A cached binary the driver no longer accepts is built from source instead.
 	GLint linkSuccessful = GL_FALSE;
 	glGetProgramiv(mProgramID, GL_LINK_STATUS, &linkSuccessful);
+	if (linkSuccessful != GL_TRUE && mCached)
+	{
+		mCached = false;
+		CompileAndLink();
+		glGetProgramiv(mProgramID, GL_LINK_STATUS, &linkSuccessful);
+	}
+
+	// Check that the shader program linked correctly.
 	if (linkSuccessful != GL_TRUE)
 	{
+		CheckShader(mVertexShaderID, mVertexShaderPath);
+		CheckShader(mFragmentShaderID, mFragmentShaderPath);
+
 		int infoLogLength = 0;
 		glGetProgramiv(mProgramID, GL_INFO_LOG_LENGTH, &infoLogLength);
 		std::vector<char> infoLog(infoLogLength + 1);
-		glGetShaderInfoLog(mProgramID, infoLogLength, NULL, &infoLog[0]);
+		glGetProgramInfoLog(mProgramID, infoLogLength, NULL, &infoLog[0]);
 		std::cerr << "Error compiling shader program : " << std::endl << &infoLog[0] << std::endl;
 	}
+	else if (!mCached && mCache != nullptr)
+		mCache->Store(mCacheKey, mProgramID);
+
+	// The shaders are only needed until the program is linked.
+	for (GLuint* shaderID : { &mVertexShaderID, &mFragmentShaderID })
+	{
+		if (*shaderID == 0) continue;
+		glDetachShader(mProgramID, *shaderID);
+		glDeleteShader(*shaderID);
+		*shaderID = 0;
+	}
+	mVertexSource.clear();
+	mFragmentSource.clear();
+}
+
+bool ShaderProgram::WasCached() const
+{
+	return mCached;
+}
+
+bool ShaderProgram::HasParallelCompile()
+{
+	static const bool hasParallelCompile = []
+	{
+		GLint extensionCount = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+		for (GLint i = 0; i < extensionCount; i++)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+			if (std::strcmp(extension, "GL_KHR_parallel_shader_compile") == 0 || std::strcmp(extension, "GL_ARB_parallel_shader_compile") == 0)
+				return true;
+		}
+		return false;
+	}();
+	return hasParallelCompile;
 }
 
 void ShaderProgram::CreateUniformBuffer(std::string name, GLsizeiptr size, int index)
 {
 	glGenBuffers(1, &mUniformBuffers[name]);
-	glBindBuffer(GL_UNIFORM_BUFFER, mUniformBuffers[name]);
+	GLStateCache::Instance().BindBuffer(GL_UNIFORM_BUFFER, mUniformBuffers[name]);
 	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	MemoryTracker::Instance().Allocate(MemoryCategory::UniformBuffers, size);
+	mOwnedUniformBufferSizes[name] = size;
 	glBindBufferBase(GL_UNIFORM_BUFFER, index, mUniformBuffers[name]);
 	glUniformBlockBinding(mProgramID, glGetUniformBlockIndex(mProgramID, name.c_str()), index);
+	mUniformBufferIndices[name] = index;
+}
+
+void ShaderProgram::ShareUniformBuffers(const ShaderProgram& other)
+{
+	// Pointing this program's blocks at the binding points the other program's buffers are bound to.
+	for (const auto& uniformBuffer : other.mUniformBuffers)
+	{
+		const int index = other.mUniformBufferIndices.at(uniformBuffer.first);
+		mUniformBuffers[uniformBuffer.first] = uniformBuffer.second;
+		mUniformBufferIndices[uniformBuffer.first] = index;
+		glUniformBlockBinding(mProgramID, glGetUniformBlockIndex(mProgramID, uniformBuffer.first.c_str()), index);
+	}
 }
 
-void ShaderProgram::SetUniformBuffer(std::string name, const void * data, GLsizeiptr size)
+void ShaderProgram::SetUniformBuffer(std::string name, const void * data, GLsizeiptr size, GLintptr offset)
 {
-	glBindBuffer(GL_UNIFORM_BUFFER, mUniformBuffers[name]);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, size, data);
+	GLStateCache::Instance().BindBuffer(GL_UNIFORM_BUFFER, mUniformBuffers[name]);
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+	RenderStats::Instance().Add(RenderCounter::UniformBytesUploaded, size);
 }
 
 void ShaderProgram::SetTextureUniform(GLuint textureID, std::string uniformName)
 {
 	// Binding the texture to a uniform variable.
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, textureID);
+	GLStateCache::Instance().BindTexture(0, GL_TEXTURE_2D, textureID);
 	glUniform1i(glGetUniformLocation(mProgramID, uniformName.c_str()), 0);
 }
 
+void ShaderProgram::SetSamplerUniform(std::string uniformName, GLint textureUnit)
+{
+	// Pointing a sampler at a texture unit without binding a texture.
+	glUniform1i(glGetUniformLocation(mProgramID, uniformName.c_str()), textureUnit);
+}
+
 
 //--------------------------------Private Functions--------------------------------
 
-GLuint ShaderProgram::LoadShader(std::string shaderPath, GLuint shaderType)
+void ShaderProgram::CompileAndLink()
+{
+	// Compile the shaders and link them, asking for a binary the cache can keep.
+	mVertexShaderID = LoadShader(mVertexSource, GL_VERTEX_SHADER);
+	mFragmentShaderID = LoadShader(mFragmentSource, GL_FRAGMENT_SHADER);
+	glAttachShader(mProgramID, mVertexShaderID);
+	glAttachShader(mProgramID, mFragmentShaderID);
+	if (mCache != nullptr)
+		glProgramParameteri(mProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(mProgramID);
+}
+
+std::string ShaderProgram::InsertDefines(const std::string& shaderSource, const std::string& defines,
+	const std::string& library)
+{
+	if (defines.empty() && library.empty()) return shaderSource;
+
+	// The library is reported to the compiler as source string 1, so its errors are told apart from the file's.
+	std::string prelude = defines;
+	if (!library.empty())
+		prelude += "#line 1 1\n" + library + "\n";
+
+	// The '#version' line must come first, and the '#line' keeps the compiler's line numbers matching the file.
+	const size_t versionEnd = shaderSource.find('\n', shaderSource.find("#version"));
+	if (versionEnd == std::string::npos) return prelude + shaderSource;
+	return shaderSource.substr(0, versionEnd + 1) + prelude + "#line 2 0\n" + shaderSource.substr(versionEnd + 1);
+}
+
+GLuint ShaderProgram::LoadShader(const std::string& shaderSource, GLuint shaderType)
 {
 	// Create the shader object.
 	GLuint shaderID = glCreateShader(shaderType);
+	auto shaderCString = shaderSource.c_str();
 
-	// Read the shader code from its file.
-	std::string shaderString = tygra::createStringFromFile(shaderPath);
-	auto shaderCString = shaderString.c_str();
-
-	// Compile the shader.
+	// Compile the shader, the result is only checked once the program is finished.
 	glShaderSource(shaderID, 1, &shaderCString, NULL);
 	glCompileShader(shaderID);
 
+	return shaderID;
+}
+
+void ShaderProgram::CheckShader(GLuint shaderID, const std::string& shaderPath) const
+{
 	// Check the shader compiled correctly.
 	GLint compileSuccessful = GL_FALSE;
 	glGetShaderiv(shaderID, GL_COMPILE_STATUS, &compileSuccessful);
@@ -100,6 +242,4 @@ GLuint ShaderProgram::LoadShader(std::string shaderPath, GLuint shaderType)
 		glGetShaderInfoLog(shaderID, infoLogLength, NULL, &infoLog[0]);
 		std::cerr << "Error compiling shader '" << shaderPath << "' : " << std::endl << &infoLog[0] << std::endl;
 	}
-
-	return shaderID;
 }
\ No newline at end of file
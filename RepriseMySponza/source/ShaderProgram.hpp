@@ -4,6 +4,9 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <unordered_map>
+#include <cstdint>
+
+#include "ProgramBinaryCache.hpp"
 
 
 
@@ -14,15 +17,53 @@ public:
 	~ShaderProgram();
 
 	void Use() const;
-	void Init(std::string vertexShaderPath, std::string fragmentShaderPath);
+	void Init(std::string vertexShaderPath, std::string fragmentShaderPath, const std::string& defines = "",
+		const std::string& fragmentLibraryPath = "");
+
+	// Starts building the program without waiting, restoring it from 'cache' when possible. Starting every
+	// program before finishing any lets a driver with parallel shader compilation build them all at once.
+	// 'defines' is inserted after the '#version' line of both shaders to specialize the program, followed in the
+	// fragment shader by the code of 'fragmentLibraryPath' so programs can share functions without copying them.
+	void BeginInit(std::string vertexShaderPath, std::string fragmentShaderPath, const std::string& defines = "",
+		ProgramBinaryCache* cache = nullptr, const std::string& fragmentLibraryPath = "");
+
+	// Whether FinishInit can return without blocking, always true without KHR_parallel_shader_compile.
+	bool IsReady() const;
+	void FinishInit();
+	bool WasCached() const;
+
+	static bool HasParallelCompile();
 	void CreateUniformBuffer(std::string name, GLsizeiptr size, int index);
-	void SetUniformBuffer(std::string name, const void * data, GLsizeiptr size);
+
+	// Uses the uniform buffers and binding points of 'other', so variants of a program share their uniforms.
+	void ShareUniformBuffers(const ShaderProgram& other);
+	void SetUniformBuffer(std::string name, const void * data, GLsizeiptr size, GLintptr offset = 0);
 	void SetTextureUniform(GLuint textureID, std::string uniformName);
+	void SetSamplerUniform(std::string uniformName, GLint textureUnit);
 
 private:
 	GLuint mProgramID;
 	std::unordered_map<std::string, GLuint> mUniformBuffers;
+	std::unordered_map<std::string, int> mUniformBufferIndices;
+
+	// The sizes of the buffers this program created, shared buffers are deleted by the program which owns them.
+	std::unordered_map<std::string, GLsizeiptr> mOwnedUniformBufferSizes;
+
+	// Kept between BeginInit and FinishInit.
+	std::string mVertexShaderPath;
+	std::string mFragmentShaderPath;
+	std::string mVertexSource;
+	std::string mFragmentSource;
+	GLuint mVertexShaderID = 0;
+	GLuint mFragmentShaderID = 0;
+	ProgramBinaryCache* mCache = nullptr;
+	uint64_t mCacheKey = 0;
+	bool mCached = false;
 
-	GLuint LoadShader(std::string shaderPath, GLuint shaderType);
+	void CompileAndLink();
+	static std::string InsertDefines(const std::string& shaderSource, const std::string& defines,
+		const std::string& library = "");
+	GLuint LoadShader(const std::string& shaderSource, GLuint shaderType);
+	void CheckShader(GLuint shaderID, const std::string& shaderPath) const;
 };
 
@@ -0,0 +1,179 @@
+#include "ShadowAtlas.hpp"
+#include "GLStateCache.hpp"
+#include "MemoryTracker.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+
+ShadowAtlas::ShadowAtlas()
+{
+}
+
+
+ShadowAtlas::~ShadowAtlas()
+{
+	Shutdown();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void ShadowAtlas::Init()
+{
+	// Comparing against the stored depth in the sampler, so shaders get filtered visibility from a single fetch.
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+	MemoryTracker::Instance().Allocate(MemoryCategory::ShadowMaps, GetTextureBytes());
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLint previousFramebuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGenFramebuffers(1, &mFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, mTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		throw std::runtime_error("shadow atlas framebuffer is incomplete");
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+}
+
+void ShadowAtlas::Shutdown()
+{
+	if (mTexture != 0)
+		MemoryTracker::Instance().Free(MemoryCategory::ShadowMaps, GetTextureBytes());
+	glDeleteFramebuffers(1, &mFramebuffer);
+	glDeleteTextures(1, &mTexture);
+	mFramebuffer = mTexture = 0;
+	mTiles.clear();
+}
+
+void ShadowAtlas::AllocateTiles(const std::vector<float>& importance)
+{
+	mTiles.resize(importance.size());
+
+	// Only changing a tile's size once its importance has more than halved or doubled, so tiles do not flicker
+	// between sizes and cached renders survive small camera movements.
+	std::vector<int> sizes(importance.size(), 0);
+	for (size_t light = 0; light < importance.size(); light++)
+	{
+		if (importance[light] <= 0.0f) continue;
+		const int previousSize = mTiles[light].size;
+		sizes[light] = ToTileSize(importance[light]);
+		if (previousSize > 0 && sizes[light] <= previousSize * 2 && sizes[light] >= previousSize / 2)
+			sizes[light] = previousSize;
+	}
+
+	// Halving the largest tiles until they all fit, then dropping the least important lights once every tile
+	// is as small as it can be.
+	const size_t atlasArea = (size_t)SHADOW_ATLAS_SIZE * SHADOW_ATLAS_SIZE;
+	while (true)
+	{
+		size_t area = 0;
+		for (int size : sizes)
+			area += (size_t)size * size;
+		if (area <= atlasArea) break;
+
+		int& largest = *std::max_element(sizes.begin(), sizes.end());
+		if (largest > SHADOW_TILE_MIN_SIZE)
+		{
+			largest /= 2;
+			continue;
+		}
+		size_t least = 0;
+		for (size_t light = 0; light < sizes.size(); light++)
+			if (sizes[light] > 0 && (sizes[least] == 0 || importance[light] < importance[least])) least = light;
+		sizes[least] = 0;
+	}
+
+	// Placing the tiles largest first along a Z-order curve, which packs power of two squares without gaps.
+	std::vector<size_t> order(importance.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sizes](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+	size_t cursor = 0;
+	for (size_t light : order)
+	{
+		ShadowTile& tile = mTiles[light];
+		int x = 0;
+		int y = 0;
+		for (int bit = 0; bit < 16; bit++)
+		{
+			x |= (int)((cursor >> (bit * 2)) & 1) << bit;
+			y |= (int)((cursor >> (bit * 2 + 1)) & 1) << bit;
+		}
+		x *= SHADOW_TILE_MIN_SIZE;
+		y *= SHADOW_TILE_MIN_SIZE;
+
+		// A tile which moves or resizes has to be rendered again.
+		if (tile.size != sizes[light] || tile.x != x || tile.y != y)
+			tile.cached = false;
+		tile.x = x;
+		tile.y = y;
+		tile.size = sizes[light];
+		cursor += (size_t)(sizes[light] / SHADOW_TILE_MIN_SIZE) * (sizes[light] / SHADOW_TILE_MIN_SIZE);
+	}
+}
+
+bool ShadowAtlas::HasTile(int light) const
+{
+	return light < (int)mTiles.size() && mTiles[light].size > 0;
+}
+
+ShadowTile& ShadowAtlas::GetTile(int light)
+{
+	return mTiles[light];
+}
+
+void ShadowAtlas::BeginTile(const ShadowTile& tile)
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	glViewport(tile.x, tile.y, tile.size, tile.size);
+	GLStateCache::Instance().Enable(GL_SCISSOR_TEST);
+	glScissor(tile.x, tile.y, tile.size, tile.size);
+	GLStateCache::Instance().DepthMask(GL_TRUE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+glm::mat4 ShadowAtlas::GetTextureXform(const ShadowTile& tile) const
+{
+	// Scaling clip space [-1, 1] into the tile's rectangle of [0, 1] texture space, and depth into [0, 1].
+	const float scale = tile.size / (float)SHADOW_ATLAS_SIZE;
+	glm::mat4 xform(1.0f);
+	xform[0][0] = 0.5f * scale;
+	xform[1][1] = 0.5f * scale;
+	xform[2][2] = 0.5f;
+	xform[3] = glm::vec4((tile.x + tile.size * 0.5f) / SHADOW_ATLAS_SIZE, (tile.y + tile.size * 0.5f) / SHADOW_ATLAS_SIZE, 0.5f, 1.0f);
+	return xform * tile.viewProjection;
+}
+
+GLuint ShadowAtlas::GetTexture() const
+{
+	return mTexture;
+}
+
+size_t ShadowAtlas::GetTextureBytes() const
+{
+	return (size_t)SHADOW_ATLAS_SIZE * SHADOW_ATLAS_SIZE * 4;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+int ShadowAtlas::ToTileSize(float importance)
+{
+	// Rounding the wanted resolution up to a power of two.
+	const float wanted = std::min(1.0f, importance) * SHADOW_TILE_MAX_SIZE;
+	int size = SHADOW_TILE_MIN_SIZE;
+	while (size < wanted && size < SHADOW_TILE_MAX_SIZE)
+		size *= 2;
+	return size;
+}
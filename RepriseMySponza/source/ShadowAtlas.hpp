@@ -0,0 +1,64 @@
+#pragma once
+
+#include <tgl/tgl.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#define SHADOW_ATLAS_SIZE 4096
+#define SHADOW_TILE_MIN_SIZE 256
+#define SHADOW_TILE_MAX_SIZE 2048
+
+
+//----------------------Structures----------------------
+
+struct ShadowTile
+{
+	int x = 0;
+	int y = 0;
+	int size = 0;
+
+	// Whether the tile still holds a valid render of its light, which a static light can keep reusing.
+	bool cached = false;
+	glm::mat4 viewProjection;
+};
+
+
+//----------------------ShadowAtlas----------------------
+
+// One depth texture shared by every shadow casting light. Each frame the lights are given square power of two
+// tiles sized by their importance on screen, packed largest first in Z-order so they never overlap. A tile
+// keeps its place while its size holds, so a cached render stays valid from frame to frame.
+class ShadowAtlas
+{
+public:
+	ShadowAtlas();
+	~ShadowAtlas();
+
+	void Init();
+	void Shutdown();
+
+	// 'importance' is indexed by light, where zero or less means the light gets no tile this frame.
+	void AllocateTiles(const std::vector<float>& importance);
+
+	bool HasTile(int light) const;
+	ShadowTile& GetTile(int light);
+
+	// Binds the atlas and clears the tile's region, which stays the only region drawn to until the next call.
+	void BeginTile(const ShadowTile& tile);
+
+	// Maps the tile's light space clip coordinates to atlas texture coordinates and depth.
+	glm::mat4 GetTextureXform(const ShadowTile& tile) const;
+
+	GLuint GetTexture() const;
+
+	// The size of the depth texture, counting each 24 bit depth as the 4 bytes drivers store it in.
+	size_t GetTextureBytes() const;
+
+private:
+	std::vector<ShadowTile> mTiles;
+	GLuint mTexture = 0;
+	GLuint mFramebuffer = 0;
+
+	static int ToTileSize(float importance);
+};
@@ -0,0 +1,89 @@
+#include "SimulationPipeline.hpp"
+#include "Utils.hpp"
+
+
+SimulationPipeline::SimulationPipeline()
+{
+}
+
+
+SimulationPipeline::~SimulationPipeline()
+{
+	// Making sure no job outlives the pipeline.
+	Stop();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void SimulationPipeline::Start(sponza::Context* scene)
+{
+	mScene = scene;
+
+	// Simulating the first frame synchronously so there is always a snapshot to render.
+	mScene->update();
+	CaptureSnapshot(*mScene, mSnapshots[mFront]);
+	mSnapshots[mFront].frameIndex = mFrameIndex++;
+
+	RunSimulationJob();
+}
+
+void SimulationPipeline::Stop()
+{
+	if (!mSimulationJob) return;
+	JobSystem::Instance().Wait(mSimulationJob);
+	mSimulationJob = nullptr;
+}
+
+const SceneSnapshot& SimulationPipeline::NextFrame(const std::function<void(sponza::Context&)>& input)
+{
+	// Helping with other jobs until the simulation finishes, after which its snapshot can be published and the
+	// scene safely modified.
+	JobSystem::Instance().Wait(mSimulationJob);
+	mFront = 1 - mFront;
+	if (input) input(*mScene);
+
+	RunSimulationJob();
+	return mSnapshots[mFront];
+}
+
+void SimulationPipeline::CaptureSnapshot(const sponza::Context& scene, SceneSnapshot& snapshot)
+{
+	snapshot.timeSeconds = scene.getTimeInSeconds();
+	snapshot.camera = scene.getCamera();
+	snapshot.upDirection = Utils::SponzaToGLMVec3(scene.getUpDirection());
+	snapshot.ambientIntensity = Utils::SponzaToGLMVec3(scene.getAmbientLightIntensity());
+	snapshot.directionalLights.assign(scene.getAllDirectionalLights().begin(), scene.getAllDirectionalLights().end());
+	snapshot.pointLights.assign(scene.getAllPointLights().begin(), scene.getAllPointLights().end());
+	snapshot.spotLights.assign(scene.getAllSpotLights().begin(), scene.getAllSpotLights().end());
+
+	// Converting the transforms here keeps the conversion off the render thread as well.
+	const auto& instances = scene.getAllInstances();
+	snapshot.instanceXforms.resize(instances.size());
+	for (size_t i = 0; i < instances.size(); i++)
+		snapshot.instanceXforms[i] = Utils::SponzaMat3ToGLMMat4(instances[i].getTransformationMatrix());
+
+	// The scene's arrays only change size while it updates, so measuring them here keeps the count current.
+	MemoryTracker::Instance().SetMeasuredBytes(MemoryCategory::SceneData, scene.getAllocatedBytes());
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+void SimulationPipeline::RunSimulationJob()
+{
+	// The frame waits on this job, so it runs at high priority rather than queueing behind asset loading. It is
+	// queued on a worker so the GL thread does not pop it back while waiting on the frame's own jobs.
+	JobSystem& jobSystem = JobSystem::Instance();
+	mSimulationJob = jobSystem.CreateJob([this] { Simulate(); });
+	jobSystem.RunOnWorker(mSimulationJob);
+}
+
+void SimulationPipeline::Simulate()
+{
+	// Simulating into the back snapshot, which the renderer does not read until it is published.
+	SceneSnapshot& snapshot = mSnapshots[1 - mFront];
+	mScene->update();
+	CaptureSnapshot(*mScene, snapshot);
+	snapshot.frameIndex = mFrameIndex++;
+}
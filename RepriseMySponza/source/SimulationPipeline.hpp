@@ -0,0 +1,64 @@
+#pragma once
+
+#include "JobSystem.hpp"
+#include "MemoryTracker.hpp"
+
+#include <sponza/sponza.hpp>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+
+
+//----------------------Structures----------------------
+
+// An immutable copy of everything the renderer reads from the scene each frame.
+struct SceneSnapshot
+{
+	uint64_t frameIndex = 0;
+	float timeSeconds = 0.0f;
+	sponza::Camera camera;
+	glm::vec3 upDirection;
+	glm::vec3 ambientIntensity;
+	TrackedVector<sponza::DirectionalLight, MemoryCategory::SceneSnapshots> directionalLights;
+	TrackedVector<sponza::PointLight, MemoryCategory::SceneSnapshots> pointLights;
+	TrackedVector<sponza::SpotLight, MemoryCategory::SceneSnapshots> spotLights;
+
+	// Indexed in the order of sponza::Context::getAllInstances.
+	TrackedVector<glm::mat4, MemoryCategory::SceneSnapshots> instanceXforms;
+};
+
+
+//----------------------SimulationPipeline----------------------
+
+// Simulates frame N+1 as a job while frame N is rendered. Each frame the renderer receives the snapshot the
+// job finished, and input is applied to the scene only while no simulation job is running.
+class SimulationPipeline
+{
+public:
+	SimulationPipeline();
+	~SimulationPipeline();
+
+	// Simulates the first frame on the calling thread and starts the job simulating the second.
+	void Start(sponza::Context* scene);
+	void Stop();
+
+	// Waits for the frame being simulated, applies 'input' to the scene and starts simulating the next frame.
+	// The returned snapshot stays valid until the next call.
+	const SceneSnapshot& NextFrame(const std::function<void(sponza::Context&)>& input);
+
+	// Must be called on the thread which updated the scene, as it also measures the scene's memory.
+	static void CaptureSnapshot(const sponza::Context& scene, SceneSnapshot& snapshot);
+
+private:
+	sponza::Context* mScene = nullptr;
+	SceneSnapshot mSnapshots[2];
+	int mFront = 0;
+	uint64_t mFrameIndex = 0;
+
+	JobHandle mSimulationJob;
+
+	void RunSimulationJob();
+	void Simulate();
+};
@@ -0,0 +1,414 @@
+#include "TextureCooker.hpp"
+
+#include <tdl/tdl.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+
+
+//--------------------------------Internal Functions--------------------------------
+
+namespace
+{
+	const char CACHE_MAGIC[4] = { 'R', 'M', 'T', 'C' };
+
+	void HashBytes(uint64_t& hash, const void* data, size_t size)
+	{
+		// FNV-1a.
+		const unsigned char* bytes = (const unsigned char*)data;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
+
+	std::vector<unsigned char> DownsampleRGBA8(const std::vector<unsigned char>& src, int srcWidth, int srcHeight, int width, int height)
+	{
+		// 2x2 box filter, clamping at the edges of odd sized levels.
+		std::vector<unsigned char> dst((size_t)width * height * 4);
+		for (int y = 0; y < height; y++)
+		{
+			const int y0 = std::min(y * 2, srcHeight - 1);
+			const int y1 = std::min(y * 2 + 1, srcHeight - 1);
+			for (int x = 0; x < width; x++)
+			{
+				const int x0 = std::min(x * 2, srcWidth - 1);
+				const int x1 = std::min(x * 2 + 1, srcWidth - 1);
+				for (int c = 0; c < 4; c++)
+				{
+					const int sum = src[((size_t)y0 * srcWidth + x0) * 4 + c] + src[((size_t)y0 * srcWidth + x1) * 4 + c]
+						+ src[((size_t)y1 * srcWidth + x0) * 4 + c] + src[((size_t)y1 * srcWidth + x1) * 4 + c];
+					dst[((size_t)y * width + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+		}
+		return dst;
+	}
+
+	uint16_t PackRGB565(const int* rgb)
+	{
+		return (uint16_t)(((rgb[0] * 31 + 127) / 255) << 11 | ((rgb[1] * 63 + 127) / 255) << 5 | ((rgb[2] * 31 + 127) / 255));
+	}
+
+	void UnpackRGB565(uint16_t packed, int* rgb)
+	{
+		rgb[0] = ((packed >> 11) & 31) * 255 / 31;
+		rgb[1] = ((packed >> 5) & 63) * 255 / 63;
+		rgb[2] = (packed & 31) * 255 / 31;
+	}
+
+	void EncodeColourBlock(const unsigned char* block, unsigned char* out)
+	{
+		// Using the corners of the colour bounding box as the end points.
+		int minColour[3] = { 255, 255, 255 };
+		int maxColour[3] = { 0, 0, 0 };
+		for (int i = 0; i < 16; i++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				minColour[c] = std::min(minColour[c], (int)block[i * 4 + c]);
+				maxColour[c] = std::max(maxColour[c], (int)block[i * 4 + c]);
+			}
+		}
+
+		uint16_t colour0 = PackRGB565(maxColour);
+		uint16_t colour1 = PackRGB565(minColour);
+		if (colour0 < colour1) std::swap(colour0, colour1);
+
+		int palette[4][3];
+		UnpackRGB565(colour0, palette[0]);
+		UnpackRGB565(colour1, palette[1]);
+		for (int c = 0; c < 3; c++)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		uint32_t indices = 0;
+		if (colour0 != colour1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+					{
+						const int d = block[i * 4 + c] - palette[p][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= (uint32_t)bestIndex << (i * 2);
+			}
+		}
+
+		out[0] = colour0 & 0xFF;
+		out[1] = colour0 >> 8;
+		out[2] = colour1 & 0xFF;
+		out[3] = colour1 >> 8;
+		std::memcpy(out + 4, &indices, 4);
+	}
+
+	void EncodeAlphaBlock(const unsigned char* block, unsigned char* out)
+	{
+		int alpha0 = 0;
+		int alpha1 = 255;
+		for (int i = 0; i < 16; i++)
+		{
+			alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+			alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+		}
+
+		// The eight value mode, interpolating six values between the end points.
+		int palette[8] = { alpha0, alpha1 };
+		for (int p = 2; p < 8; p++)
+			palette[p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (int i = 0; i < 16; i++)
+			{
+				int bestIndex = 0;
+				for (int p = 1; p < 8; p++)
+				{
+					if (std::abs(block[i * 4 + 3] - palette[p]) < std::abs(block[i * 4 + 3] - palette[bestIndex]))
+						bestIndex = p;
+				}
+				indices |= (uint64_t)bestIndex << (i * 3);
+			}
+		}
+
+		out[0] = (unsigned char)alpha0;
+		out[1] = (unsigned char)alpha1;
+		for (int b = 0; b < 6; b++)
+			out[2 + b] = (unsigned char)(indices >> (b * 8));
+	}
+
+	std::vector<unsigned char> CompressLevel(const std::vector<unsigned char>& pixels, int width, int height, CookedFormat format)
+	{
+		const int blocksX = (width + 3) / 4;
+		const int blocksY = (height + 3) / 4;
+		const size_t blockBytes = format == CookedFormat::BC1 ? 8 : 16;
+		std::vector<unsigned char> data(blocksX * blocksY * blockBytes);
+
+		unsigned char block[16 * 4];
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				// Gathering the 4x4 block, repeating edge pixels for levels smaller than a block.
+				for (int y = 0; y < 4; y++)
+				{
+					const int sy = std::min(by * 4 + y, height - 1);
+					for (int x = 0; x < 4; x++)
+					{
+						const int sx = std::min(bx * 4 + x, width - 1);
+						std::memcpy(block + (y * 4 + x) * 4, &pixels[((size_t)sy * width + sx) * 4], 4);
+					}
+				}
+
+				unsigned char* out = &data[(by * blocksX + bx) * blockBytes];
+				if (format == CookedFormat::BC3)
+				{
+					EncodeAlphaBlock(block, out);
+					out += 8;
+				}
+				EncodeColourBlock(block, out);
+			}
+		}
+		return data;
+	}
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+uint64_t TextureCooker::ComputeCacheKey(const std::vector<std::string>& names, bool compress)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const uint32_t version = TEXTURE_CACHE_VERSION;
+	HashBytes(hash, &version, sizeof(version));
+	HashBytes(hash, &compress, sizeof(compress));
+	std::vector<char> buffer(64 * 1024);
+	for (const auto& name : names)
+	{
+		// Including the bytes of each source so any edit to an image invalidates the cache, reading the compressed
+		// file is still far cheaper than decoding it.
+		HashBytes(hash, name.data(), name.size());
+		int64_t size = -1;
+		tdlStream* stream = tdlCreateStreamFromUri(name.c_str(), nullptr);
+		if (stream != nullptr)
+		{
+			size = 0;
+			for (;;)
+			{
+				tdlError* error = nullptr;
+				size_t count = buffer.size();
+				tdlReadStream(stream, &error, &count, buffer.data());
+				if (error != nullptr)
+				{
+					tdlFreeError(error);
+					size = -1;
+					break;
+				}
+				if (count == 0) break;
+				HashBytes(hash, buffer.data(), count);
+				size += count;
+			}
+			tdlFreeStream(stream);
+		}
+		HashBytes(hash, &size, sizeof(size));
+	}
+	return hash;
+}
+
+std::string TextureCooker::GetCachePath(uint64_t key)
+{
+	std::ostringstream path;
+	path << "texture_cache_" << std::hex << std::setw(16) << std::setfill('0') << key << ".rmtc";
+	return path.str();
+}
+
+bool TextureCooker::LoadCookedTexture(const std::string& path, uint64_t key, CookedTexture& texture)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	char magic[4];
+	uint32_t version;
+	uint64_t fileKey;
+	uint32_t header[5];
+	file.read(magic, sizeof(magic));
+	file.read((char*)&version, sizeof(version));
+	file.read((char*)&fileKey, sizeof(fileKey));
+	file.read((char*)header, sizeof(header));
+	if (!file || std::memcmp(magic, CACHE_MAGIC, 4) != 0 || version != TEXTURE_CACHE_VERSION || fileKey != key)
+		return false;
+
+	// Rejecting a header the cooker could not have written, it always writes a full mip chain.
+	if (header[0] > (uint32_t)CookedFormat::BC3 || header[1] == 0 || header[1] > MAX_COOKED_TEXTURE_SIZE
+		|| header[2] == 0 || header[2] > MAX_COOKED_TEXTURE_SIZE || header[3] == 0 || header[3] > MAX_COOKED_TEXTURE_SLICES)
+		return false;
+	uint32_t fullMipCount = 1;
+	while ((std::max(header[1], header[2]) >> fullMipCount) > 0) fullMipCount++;
+	if (header[4] != fullMipCount) return false;
+
+	texture.format = (CookedFormat)header[0];
+	texture.width = header[1];
+	texture.height = header[2];
+	texture.sliceCount = header[3];
+	texture.mipCount = header[4];
+	texture.levels.clear();
+	for (int slice = 0; slice < texture.sliceCount; slice++)
+	{
+		for (int mip = 0; mip < texture.mipCount; mip++)
+		{
+			CookedLevel level;
+			level.slice = slice;
+			level.mip = mip;
+			level.width = std::max(1, texture.width >> mip);
+			level.height = std::max(1, texture.height >> mip);
+			const int rowHeight = GetRowHeight(texture.format);
+			const size_t expectedSize = GetRowBytes(texture.format, level.width) * ((level.height + rowHeight - 1) / rowHeight);
+			uint32_t size = 0;
+			file.read((char*)&size, sizeof(size));
+			if (file && size == expectedSize)
+			{
+				level.data.resize(size);
+				file.read((char*)level.data.data(), size);
+			}
+			if (!file || size != expectedSize)
+			{
+				texture.levels.clear();
+				return false;
+			}
+			texture.levels.push_back(std::move(level));
+		}
+	}
+	return true;
+}
+
+bool TextureCooker::SaveCookedTexture(const std::string& path, uint64_t key, const CookedTexture& texture)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file) return false;
+
+	const uint32_t version = TEXTURE_CACHE_VERSION;
+	const uint32_t header[5] = { (uint32_t)texture.format, (uint32_t)texture.width, (uint32_t)texture.height,
+		(uint32_t)texture.sliceCount, (uint32_t)texture.mipCount };
+	file.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	file.write((const char*)&version, sizeof(version));
+	file.write((const char*)&key, sizeof(key));
+	file.write((const char*)header, sizeof(header));
+	for (const auto& level : texture.levels)
+	{
+		const uint32_t size = level.data.size();
+		file.write((const char*)&size, sizeof(size));
+		file.write((const char*)level.data.data(), size);
+	}
+	return (bool)file;
+}
+
+CookedTexture TextureCooker::CookTexture(const std::vector<std::vector<unsigned char>>& slices, int width, int height, bool compress)
+{
+	CookedTexture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.sliceCount = slices.size();
+	texture.mipCount = 1;
+	while ((std::max(width, height) >> texture.mipCount) > 0) texture.mipCount++;
+
+	// Only paying for an alpha block when some pixel is not opaque.
+	texture.format = CookedFormat::RGBA8;
+	if (compress)
+	{
+		texture.format = CookedFormat::BC1;
+		for (const auto& slice : slices)
+			for (size_t i = 3; i < slice.size() && texture.format == CookedFormat::BC1; i += 4)
+				if (slice[i] != 255) texture.format = CookedFormat::BC3;
+	}
+
+	for (int slice = 0; slice < texture.sliceCount; slice++)
+	{
+		std::vector<unsigned char> pixels = slices[slice];
+		for (int mip = 0; mip < texture.mipCount; mip++)
+		{
+			CookedLevel level;
+			level.slice = slice;
+			level.mip = mip;
+			level.width = std::max(1, width >> mip);
+			level.height = std::max(1, height >> mip);
+			if (mip > 0)
+				pixels = DownsampleRGBA8(pixels, std::max(1, width >> (mip - 1)), std::max(1, height >> (mip - 1)), level.width, level.height);
+			if (IsCompressed(texture.format))
+			{
+				const std::vector<unsigned char> blocks = CompressLevel(pixels, level.width, level.height, texture.format);
+				level.data.assign(blocks.begin(), blocks.end());
+			}
+			else
+				level.data.assign(pixels.begin(), pixels.end());
+			texture.levels.push_back(std::move(level));
+		}
+	}
+	return texture;
+}
+
+GLenum TextureCooker::GetInternalFormat(CookedFormat format)
+{
+	switch (format)
+	{
+	case CookedFormat::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case CookedFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	default: return GL_RGBA8;
+	}
+}
+
+bool TextureCooker::IsCompressed(CookedFormat format)
+{
+	return format != CookedFormat::RGBA8;
+}
+
+int TextureCooker::GetRowHeight(CookedFormat format)
+{
+	// Compressed levels are uploaded in whole rows of 4x4 blocks.
+	return IsCompressed(format) ? 4 : 1;
+}
+
+size_t TextureCooker::GetRowBytes(CookedFormat format, int width)
+{
+	switch (format)
+	{
+	case CookedFormat::BC1: return ((width + 3) / 4) * 8;
+	case CookedFormat::BC3: return ((width + 3) / 4) * 16;
+	default: return (size_t)width * 4;
+	}
+}
+
+size_t TextureCooker::GetTotalBytes(const CookedTexture& texture)
+{
+	size_t total = 0;
+	for (const auto& level : texture.levels)
+		total += level.data.size();
+	return total;
+}
+
+const char* TextureCooker::GetFormatName(CookedFormat format)
+{
+	switch (format)
+	{
+	case CookedFormat::BC1: return "BC1";
+	case CookedFormat::BC3: return "BC3";
+	default: return "RGBA8";
+	}
+}
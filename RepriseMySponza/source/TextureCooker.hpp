@@ -0,0 +1,79 @@
+#pragma once
+
+#include <tgl/tgl.h>
+#include "MemoryTracker.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The S3TC formats are an extension so they are not declared by the core profile headers.
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#define TEXTURE_CACHE_VERSION 1
+
+// Limits a cached header must fall within, matching what GL 3.3 drivers commonly allow.
+#define MAX_COOKED_TEXTURE_SIZE 16384
+#define MAX_COOKED_TEXTURE_SLICES 2048
+
+
+//----------------------Enumerations----------------------
+
+enum class CookedFormat : uint32_t
+{
+	RGBA8 = 0,
+	BC1 = 1,
+	BC3 = 2
+};
+
+
+//----------------------Structures----------------------
+
+struct CookedLevel
+{
+	int slice;
+	int mip;
+	int width;
+	int height;
+	TrackedVector<unsigned char, MemoryCategory::CookedTextures> data;
+};
+
+struct CookedTexture
+{
+	CookedFormat format = CookedFormat::RGBA8;
+	int width = 0;
+	int height = 0;
+	int sliceCount = 0;
+	int mipCount = 0;
+	std::vector<CookedLevel> levels;
+};
+
+
+//----------------------TextureCooker----------------------
+
+// Builds full mip chains on the CPU, optionally block compresses them, and caches the result on disk so
+// later runs can upload every level directly.
+namespace TextureCooker
+{
+	// Hashes the source names, their file contents and the requested format into a cache key.
+	uint64_t ComputeCacheKey(const std::vector<std::string>& names, bool compress);
+	std::string GetCachePath(uint64_t key);
+
+	bool LoadCookedTexture(const std::string& path, uint64_t key, CookedTexture& texture);
+	bool SaveCookedTexture(const std::string& path, uint64_t key, const CookedTexture& texture);
+
+	// Cooks RGBA8 slices of identical size, choosing BC1 or BC3 depending on alpha when compressing.
+	CookedTexture CookTexture(const std::vector<std::vector<unsigned char>>& slices, int width, int height, bool compress);
+
+	GLenum GetInternalFormat(CookedFormat format);
+	bool IsCompressed(CookedFormat format);
+	int GetRowHeight(CookedFormat format);
+	size_t GetRowBytes(CookedFormat format, int width);
+	size_t GetTotalBytes(const CookedTexture& texture);
+	const char* GetFormatName(CookedFormat format);
+}
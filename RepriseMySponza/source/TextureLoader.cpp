@@ -0,0 +1,376 @@
+#include "TextureLoader.hpp"
+#include "Utils.hpp"
+#include "RenderStats.hpp"
+
+#include <tygra/FileHelper.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+
+TextureLoader::TextureLoader()
+{
+}
+
+
+TextureLoader::~TextureLoader()
+{
+	// Making sure no worker outlives the loader.
+	Stop();
+}
+
+
+//--------------------------------Public Functions--------------------------------
+
+void TextureLoader::Start()
+{
+	// Creating the 1x1 placeholders which are bound until a texture is resident.
+	const unsigned char white[4] = { 255, 255, 255, 255 };
+	glGenTextures(1, &mPlaceholderArray);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, mPlaceholderArray);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, 1, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	const unsigned char grey[4] = { 64, 64, 64, 255 };
+	glGenTextures(1, &mPlaceholderCube);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, mPlaceholderCube);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	for (int face = 0; face < 6; face++)
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	MemoryTracker::Instance().Allocate(MemoryCategory::Textures, TEXTURE_PLACEHOLDER_BYTES);
+
+	glGenBuffers(1, &mUnpackBuffer);
+
+	// Block compressing the cooked textures only when the driver can sample S3TC formats.
+	GLint extensionCount = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensionCount);
+	mCompress = false;
+	for (GLint i = 0; i < extensionCount && !mCompress; i++)
+		mCompress = std::strcmp((const char*)glGetStringi(GL_EXTENSIONS, i), "GL_EXT_texture_compression_s3tc") == 0;
+
+	// Every loading job is a child of this one, so waiting on it waits for all of them.
+	mStopping = false;
+	mLoadJobs = JobSystem::Instance().CreateJob(nullptr);
+}
+
+void TextureLoader::Stop()
+{
+	// Queued jobs see the flag and return straight away, so this only waits for jobs already decoding.
+	mStopping = true;
+	if (mLoadJobs)
+	{
+		JobSystem::Instance().Run(mLoadJobs);
+		while (!JobSystem::Instance().IsComplete(mLoadJobs))
+			JobSystem::Instance().Help();
+		mLoadJobs = nullptr;
+	}
+
+	// Deleting the GL objects, only possible if the loader was started.
+	if (mUnpackBuffer == 0) return;
+	MemoryTracker& memoryTracker = MemoryTracker::Instance();
+	for (const auto& texture : mTextures)
+	{
+		if (texture->texture != 0)
+			memoryTracker.Free(MemoryCategory::Textures, texture->textureBytes);
+		glDeleteTextures(1, &texture->texture);
+	}
+	mTextures.clear();
+	glDeleteTextures(1, &mPlaceholderArray);
+	glDeleteTextures(1, &mPlaceholderCube);
+	glDeleteBuffers(1, &mUnpackBuffer);
+	memoryTracker.Free(MemoryCategory::Textures, TEXTURE_PLACEHOLDER_BYTES);
+	memoryTracker.Free(MemoryCategory::StagingBuffers, mUnpackBufferBytes);
+	mPlaceholderArray = mPlaceholderCube = mUnpackBuffer = 0;
+	mUnpackBufferBytes = 0;
+}
+
+TextureHandle TextureLoader::RequestTexture(TextureType type, const std::vector<std::string>& names)
+{
+	if (names.empty()) return INVALID_TEXTURE_HANDLE;
+
+	std::unique_ptr<PendingTexture> texture(new PendingTexture());
+	texture->type = type;
+	texture->names = names;
+	texture->images.resize(names.size());
+	texture->requestTime = std::chrono::steady_clock::now();
+
+	// Queueing a cache probe, the slices are only decoded if there is no cooked copy.
+	TextureHandle handle;
+	PendingTexture* pendingTexture = texture.get();
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		handle = mTextures.size();
+		mTextures.push_back(std::move(texture));
+	}
+	RunLoadJob([this, pendingTexture] { ProbeCache(*pendingTexture); });
+	return handle;
+}
+
+void TextureLoader::Update(size_t byteBudget)
+{
+	for (size_t handle = 0; handle < mTextures.size() && byteBudget > 0; handle++)
+	{
+		PendingTexture& texture = *mTextures[handle];
+		if (texture.resident) continue;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (!texture.decoded) continue;
+		}
+
+		const auto uploadStart = std::chrono::steady_clock::now();
+		if (texture.texture == 0)
+			AllocateTexture(texture);
+		UploadChunk(texture, byteBudget);
+		texture.uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+		if (texture.uploadLevel == texture.cooked.levels.size())
+			FinishTexture(texture);
+	}
+}
+
+GLuint TextureLoader::GetTexture(TextureHandle handle) const
+{
+	if (handle < mTextures.size() && mTextures[handle]->resident)
+		return mTextures[handle]->texture;
+	if (handle < mTextures.size() && mTextures[handle]->type == TextureType::CubeMap)
+		return mPlaceholderCube;
+	return mPlaceholderArray;
+}
+
+bool TextureLoader::IsResident(TextureHandle handle) const
+{
+	return handle < mTextures.size() && mTextures[handle]->resident;
+}
+
+bool TextureLoader::IsIdle() const
+{
+	for (const auto& texture : mTextures)
+		if (!texture->resident) return false;
+	return true;
+}
+
+
+//--------------------------------Private Functions--------------------------------
+
+void TextureLoader::RunLoadJob(std::function<void()> function)
+{
+	// Loading is background work, so it never stalls a thread waiting on the frame's jobs.
+	JobSystem& jobSystem = JobSystem::Instance();
+	jobSystem.Run(jobSystem.CreateJob([this, function]
+	{
+		if (!mStopping) function();
+	}, mLoadJobs, JobPriority::Low));
+}
+
+void TextureLoader::DecodeSlice(PendingTexture& texture, int slice)
+{
+	// Each job owns its own slice.
+	std::unique_ptr<tygra::Image> image(new tygra::Image(tygra::createImageFromPngFile(texture.names[slice])));
+	if (!image->doesContainData())
+		std::cerr << "Warning : Texture '" << texture.names[slice] << "' does not contain any data." << std::endl;
+
+	bool lastSlice = false;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		texture.images[slice] = std::move(image);
+		lastSlice = ++texture.decodedCount == (int)texture.names.size();
+	}
+
+	// The job which decodes the final slice cooks the whole texture for upload.
+	if (lastSlice)
+	{
+		CookSlices(texture);
+		std::lock_guard<std::mutex> lock(mMutex);
+		texture.decoded = true;
+	}
+}
+
+void TextureLoader::ProbeCache(PendingTexture& texture)
+{
+	texture.cacheKey = TextureCooker::ComputeCacheKey(texture.names, mCompress);
+	texture.cacheHit = TextureCooker::LoadCookedTexture(TextureCooker::GetCachePath(texture.cacheKey), texture.cacheKey, texture.cooked);
+
+	if (texture.cacheHit)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		texture.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - texture.requestTime).count();
+		texture.decoded = true;
+		return;
+	}
+
+	// Queueing one decode job per slice so the slices of a texture decode in parallel.
+	for (int slice = 0; slice < (int)texture.names.size(); slice++)
+		RunLoadJob([this, &texture, slice] { DecodeSlice(texture, slice); });
+}
+
+void TextureLoader::CookSlices(PendingTexture& texture)
+{
+	// The first valid slice decides the size of the texture, the others are resampled to match.
+	int width = 1;
+	int height = 1;
+	for (const auto& image : texture.images)
+	{
+		if (image->doesContainData())
+		{
+			width = image->width();
+			height = image->height();
+			break;
+		}
+	}
+
+	const size_t sliceBytes = (size_t)width * height * 4;
+	std::vector<std::vector<unsigned char>> slices(texture.images.size());
+	for (size_t slice = 0; slice < texture.images.size(); slice++)
+	{
+		if (texture.images[slice]->doesContainData())
+			slices[slice] = Utils::ConvertImageToRGBA8(*texture.images[slice], width, height);
+		else
+			slices[slice].assign(sliceBytes, 255);
+	}
+
+	// The decoded images are no longer needed.
+	texture.images.clear();
+
+	// Building the mip chain and writing it to the cache so the next run can skip decoding.
+	texture.cooked = TextureCooker::CookTexture(slices, width, height, mCompress);
+	if (!TextureCooker::SaveCookedTexture(TextureCooker::GetCachePath(texture.cacheKey), texture.cacheKey, texture.cooked))
+		std::cerr << "Warning : Unable to write the texture cache for '" << texture.names[0] << "'." << std::endl;
+	texture.loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - texture.requestTime).count();
+}
+
+void TextureLoader::AllocateTexture(PendingTexture& texture)
+{
+	const CookedTexture& cooked = texture.cooked;
+	const GLenum internalFormat = TextureCooker::GetInternalFormat(cooked.format);
+	texture.textureBytes = TextureCooker::GetTotalBytes(cooked);
+	MemoryTracker::Instance().Allocate(MemoryCategory::Textures, texture.textureBytes);
+
+	// Allocating every level up front, the cooked levels are then streamed in without generating mipmaps.
+	glGenTextures(1, &texture.texture);
+	if (texture.type == TextureType::Array2D)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture.texture);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, cooked.mipCount - 1);
+		for (int mip = 0; mip < cooked.mipCount; mip++)
+		{
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, mip, internalFormat, std::max(1, cooked.width >> mip), std::max(1, cooked.height >> mip),
+				cooked.sliceCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_CUBE_MAP, texture.texture);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+		glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, cooked.mipCount - 1);
+		for (int face = 0; face < cooked.sliceCount; face++)
+		{
+			for (int mip = 0; mip < cooked.mipCount; mip++)
+			{
+				glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, mip, internalFormat, std::max(1, cooked.width >> mip),
+					std::max(1, cooked.height >> mip), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+			}
+		}
+		glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+	}
+}
+
+void TextureLoader::UploadChunk(PendingTexture& texture, size_t& byteBudget)
+{
+	const CookedFormat format = texture.cooked.format;
+	const GLenum internalFormat = TextureCooker::GetInternalFormat(format);
+	const int rowHeight = TextureCooker::GetRowHeight(format);
+	const GLenum target = texture.type == TextureType::Array2D ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_CUBE_MAP;
+	glBindTexture(target, texture.texture);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, mUnpackBuffer);
+
+	while (texture.uploadLevel < texture.cooked.levels.size() && byteBudget > 0)
+	{
+		CookedLevel& level = texture.cooked.levels[texture.uploadLevel];
+		const size_t rowBytes = TextureCooker::GetRowBytes(format, level.width);
+
+		// Copying as many rows (of blocks when compressed) as the budget allows into the unpack buffer, at least one.
+		const int rowsLeft = (level.height - texture.uploadRow + rowHeight - 1) / rowHeight;
+		const int rows = std::max(1, std::min(rowsLeft, (int)(byteBudget / rowBytes)));
+		const int pixelRows = std::min(rows * rowHeight, level.height - texture.uploadRow);
+		const size_t chunkBytes = rows * rowBytes;
+		const unsigned char* source = level.data.data() + (texture.uploadRow / rowHeight) * rowBytes;
+
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, chunkBytes, nullptr, GL_STREAM_DRAW);
+		MemoryTracker::Instance().Free(MemoryCategory::StagingBuffers, mUnpackBufferBytes);
+		MemoryTracker::Instance().Allocate(MemoryCategory::StagingBuffers, chunkBytes);
+		mUnpackBufferBytes = chunkBytes;
+		void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, chunkBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped == nullptr) break;
+		std::memcpy(mapped, source, chunkBytes);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		if (texture.type == TextureType::Array2D)
+		{
+			if (TextureCooker::IsCompressed(format))
+				glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, level.mip, 0, texture.uploadRow, level.slice, level.width, pixelRows, 1,
+					internalFormat, chunkBytes, TGL_BUFFER_OFFSET(0));
+			else
+				glTexSubImage3D(GL_TEXTURE_2D_ARRAY, level.mip, 0, texture.uploadRow, level.slice, level.width, pixelRows, 1,
+					GL_RGBA, GL_UNSIGNED_BYTE, TGL_BUFFER_OFFSET(0));
+		}
+		else
+		{
+			const GLenum face = GL_TEXTURE_CUBE_MAP_POSITIVE_X + level.slice;
+			if (TextureCooker::IsCompressed(format))
+				glCompressedTexSubImage2D(face, level.mip, 0, texture.uploadRow, level.width, pixelRows,
+					internalFormat, chunkBytes, TGL_BUFFER_OFFSET(0));
+			else
+				glTexSubImage2D(face, level.mip, 0, texture.uploadRow, level.width, pixelRows,
+					GL_RGBA, GL_UNSIGNED_BYTE, TGL_BUFFER_OFFSET(0));
+		}
+
+		byteBudget -= std::min(byteBudget, chunkBytes);
+		RenderStats::Instance().Add(RenderCounter::TextureBytesUploaded, chunkBytes);
+		texture.uploadRow += pixelRows;
+		if (texture.uploadRow == level.height)
+		{
+			// Releasing the level as soon as it is on the GPU.
+			TrackedVector<unsigned char, MemoryCategory::CookedTextures>().swap(level.data);
+			texture.uploadLevel++;
+			texture.uploadRow = 0;
+		}
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	glBindTexture(target, 0);
+}
+
+void TextureLoader::FinishTexture(PendingTexture& texture)
+{
+	texture.resident = true;
+	PrintTextureReport(texture);
+	texture.cooked.levels.clear();
+}
+
+void TextureLoader::PrintTextureReport(const PendingTexture& texture) const
+{
+	// Comparing against the RGBA8 texture with a full mip chain which was uploaded before cooking.
+	const CookedTexture& cooked = texture.cooked;
+	size_t uncompressedBytes = 0;
+	for (int mip = 0; mip < cooked.mipCount; mip++)
+		uncompressedBytes += (size_t)std::max(1, cooked.width >> mip) * std::max(1, cooked.height >> mip) * 4 * cooked.sliceCount;
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< "Texture '" << texture.names[0] << "'" << (texture.names.size() > 1 ? " (+" + std::to_string(texture.names.size() - 1) + " slices)" : "")
+		<< " : " << TextureCooker::GetFormatName(cooked.format) << ", " << cooked.mipCount << " mips, "
+		<< texture.textureBytes / 1024 << " KB (RGBA8 " << uncompressedBytes / 1024 << " KB), "
+		<< (texture.cacheHit ? "cache hit" : "cooked") << " in " << texture.loadMs << " ms, uploaded in " << texture.uploadMs << " ms"
+		<< std::endl;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <tgl/tgl.h>
+#include <tygra/Image.hpp>
+#include "TextureCooker.hpp"
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+#define INVALID_TEXTURE_HANDLE 0xFFFFFFFF
+// The 1x1 RGBA8 placeholders, one array layer and six cube faces.
+#define TEXTURE_PLACEHOLDER_BYTES (7 * 4)
+
+typedef uint32_t TextureHandle;
+
+
+//----------------------Enumerations----------------------
+
+enum class TextureType
+{
+	Array2D,
+	CubeMap
+};
+
+
+//----------------------TextureLoader----------------------
+
+// Loads cooked mip chains from the texture cache, or decodes and cooks the PNG files as background jobs, and
+// streams every level to GL through a pixel unpack buffer in budgeted chunks, so loading never blocks a frame.
+// A placeholder is returned until a texture is resident.
+class TextureLoader
+{
+public:
+	TextureLoader();
+	~TextureLoader();
+
+	void Start();
+	void Stop();
+
+	// Queues the files making up the slices (array layers or cube faces) of a single texture.
+	TextureHandle RequestTexture(TextureType type, const std::vector<std::string>& names);
+
+	// Uploads at most 'byteBudget' bytes of decoded pixels, must be called on the GL thread.
+	void Update(size_t byteBudget);
+
+	GLuint GetTexture(TextureHandle handle) const;
+	bool IsResident(TextureHandle handle) const;
+	bool IsIdle() const;
+
+private:
+	struct PendingTexture
+	{
+		TextureType type;
+		std::vector<std::string> names;
+		std::vector<std::unique_ptr<tygra::Image>> images;
+		CookedTexture cooked;
+		uint64_t cacheKey = 0;
+		bool cacheHit = false;
+		int decodedCount = 0;
+		bool decoded = false;
+		bool resident = false;
+		size_t uploadLevel = 0;
+		int uploadRow = 0;
+		GLuint texture = 0;
+		size_t textureBytes = 0;
+		std::chrono::steady_clock::time_point requestTime;
+		double loadMs = 0.0;
+		double uploadMs = 0.0;
+	};
+
+	std::vector<std::unique_ptr<PendingTexture>> mTextures;
+	mutable std::mutex mMutex;
+	JobHandle mLoadJobs;
+	std::atomic<bool> mStopping;
+	bool mCompress = false;
+
+	GLuint mPlaceholderArray = 0;
+	GLuint mPlaceholderCube = 0;
+	GLuint mUnpackBuffer = 0;
+	size_t mUnpackBufferBytes = 0;
+
+	void RunLoadJob(std::function<void()> function);
+	void ProbeCache(PendingTexture& texture);
+	void DecodeSlice(PendingTexture& texture, int slice);
+	void CookSlices(PendingTexture& texture);
+	void AllocateTexture(PendingTexture& texture);
+	void UploadChunk(PendingTexture& texture, size_t& byteBudget);
+	void FinishTexture(PendingTexture& texture);
+	void PrintTextureReport(const PendingTexture& texture) const;
+};
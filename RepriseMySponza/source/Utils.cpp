@@ -1,4 +1,5 @@
 #include "Utils.hpp"
+#include <algorithm>
 
 glm::vec3 Utils::SponzaToGLMVec3(const sponza::Vector3& v)
 {
@@ -11,4 +12,93 @@ glm::mat4 Utils::SponzaMat3ToGLMMat4(const sponza::Matrix4x3& m)
 		m.m10, m.m11, m.m12, 0,
 		m.m20, m.m21, m.m22, 0,
 		m.m30, m.m31, m.m32, 1);
-}
\ No newline at end of file
+}
+
+std::vector<unsigned char> Utils::ConvertImageToRGBA8(const tygra::Image& image, int width, int height)
+{
+	const int srcWidth = image.width();
+	const int srcHeight = image.height();
+	const int components = image.componentsPerPixel();
+	const int bytesPerComponent = image.bytesPerComponent();
+	const unsigned char* src = (const unsigned char*)image.pixelData();
+
+	// Reading a channel as 8 bits, expanding grey images and keeping the high byte of 16 bit components.
+	auto fetch = [&](int x, int y, int c) -> float
+	{
+		if (components < 3) c = (c == 3) ? (components == 2 ? 1 : -1) : 0;
+		else if (c >= components) c = -1;
+		if (c < 0) return 255.f;
+		const size_t offset = ((size_t)y * srcWidth + x) * components + c;
+		return bytesPerComponent == 1 ? src[offset] : (float)(((const unsigned short*)src)[offset] >> 8);
+	};
+
+	std::vector<unsigned char> pixels((size_t)width * height * 4);
+	for (int y = 0; y < height; y++)
+	{
+		// Bilinearly resampling when the destination size differs from the image.
+		const float sy = std::max(0.f, (y + 0.5f) * srcHeight / height - 0.5f);
+		const int y0 = std::min((int)sy, srcHeight - 1);
+		const int y1 = std::min(y0 + 1, srcHeight - 1);
+		const float fy = sy - y0;
+		for (int x = 0; x < width; x++)
+		{
+			const float sx = std::max(0.f, (x + 0.5f) * srcWidth / width - 0.5f);
+			const int x0 = std::min((int)sx, srcWidth - 1);
+			const int x1 = std::min(x0 + 1, srcWidth - 1);
+			const float fx = sx - x0;
+			for (int c = 0; c < 4; c++)
+			{
+				const float top = fetch(x0, y0, c) * (1 - fx) + fetch(x1, y0, c) * fx;
+				const float bottom = fetch(x0, y1, c) * (1 - fx) + fetch(x1, y1, c) * fx;
+				pixels[((size_t)y * width + x) * 4 + c] = (unsigned char)(top * (1 - fy) + bottom * fy + 0.5f);
+			}
+		}
+	}
+	return pixels;
+}
+
+void Utils::ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6])
+{
+	// Adding and subtracting the first three rows of the matrix from the fourth (Gribb and Hartmann).
+	const glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+	const glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+	const glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+	const glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+	planes[0] = row3 + row0;
+	planes[1] = row3 - row0;
+	planes[2] = row3 + row1;
+	planes[3] = row3 - row1;
+	planes[4] = row3 + row2;
+	planes[5] = row3 - row2;
+	for (int i = 0; i < 6; i++)
+		planes[i] /= glm::length(glm::vec3(planes[i]));
+}
+
+bool Utils::IsSphereInFrustum(const glm::vec4 planes[6], const glm::vec3& centre, float radius)
+{
+	for (int i = 0; i < 6; i++)
+		if (glm::dot(glm::vec3(planes[i]), centre) + planes[i].w < -radius)
+			return false;
+	return true;
+}
+
+float Utils::TransformRadius(const glm::mat4& xform, float radius)
+{
+	const float scale = std::max(glm::length(glm::vec3(xform[0])), std::max(glm::length(glm::vec3(xform[1])), glm::length(glm::vec3(xform[2]))));
+	return radius * scale;
+}
+
+void Utils::ToAffineRows(const glm::mat4& xform, glm::vec4 rows[3])
+{
+	for (int row = 0; row < 3; row++)
+		rows[row] = glm::vec4(xform[0][row], xform[1][row], xform[2][row], xform[3][row]);
+}
+
+glm::mat4 Utils::FromAffineRows(const glm::vec4 rows[3])
+{
+	glm::mat4 xform(1.0f);
+	for (int row = 0; row < 3; row++)
+		for (int column = 0; column < 4; column++)
+			xform[column][row] = rows[row][column];
+	return xform;
+}
@@ -2,11 +2,25 @@
 
 #include <glm/glm.hpp>
 #include <sponza/sponza_fwd.hpp>
+#include <tygra/Image.hpp>
+#include <vector>
 
 namespace Utils
 {
 	glm::vec3 SponzaToGLMVec3(const sponza::Vector3& v);
 	glm::mat4 SponzaMat3ToGLMMat4(const sponza::Matrix4x3& m);
+	std::vector<unsigned char> ConvertImageToRGBA8(const tygra::Image& image, int width, int height);
+
+	// Extracts the left, right, bottom, top, near and far planes, with normals pointing into the frustum.
+	void ExtractFrustumPlanes(const glm::mat4& viewProjection, glm::vec4 planes[6]);
+	bool IsSphereInFrustum(const glm::vec4 planes[6], const glm::vec3& centre, float radius);
+
+	// The radius of a model space sphere once transformed by 'xform', which may be non-uniformly scaled.
+	float TransformRadius(const glm::mat4& xform, float radius);
+
+	// Converts between an affine xform and its top three rows, the bottom row being (0, 0, 0, 1).
+	void ToAffineRows(const glm::mat4& xform, glm::vec4 rows[3]);
+	glm::mat4 FromAffineRows(const glm::vec4 rows[3]);
 }
 
 
@@ -1,4 +1,5 @@
 #include "MyController.hpp"
+#include "Benchmark.hpp"
 
 #include <tygra/Window.hpp>
 
@@ -6,14 +7,38 @@
 #include <cstdlib>
 #include <iostream>
 #include <memory>
+#include <string>
 
 int main(int argc, char *argv[])
 {
     // enable debug memory checks
     _CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 
+    // run the offscreen benchmark instead of the interactive demo:
+    //   RepriseMySponza --benchmark [frame_count]
+    if (argc > 1 && std::string(argv[1]) == "--benchmark") {
+        try {
+            const int frame_count = argc > 2 ? std::atoi(argv[2])
+                : BENCHMARK_DEFAULT_FRAMES;
+            Benchmark benchmark(frame_count);
+            return benchmark.Run();
+        } catch (const std::exception& e) {
+            std::cerr << "Benchmark failed:" << std::endl;
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // stream the meshes within a GPU memory budget:
+    //   RepriseMySponza --mesh-budget megabytes
+    size_t mesh_memory_budget = 0;
+    if (argc > 2 && std::string(argv[1]) == "--mesh-budget") {
+        mesh_memory_budget = (size_t)std::atoi(argv[2]) * 1024 * 1024;
+    }
+
     try {
-        auto controller = std::make_unique<MyController>();
+        auto controller
+            = std::make_unique<MyController>(mesh_memory_budget);
         auto window = tygra::Window::mainWindow();
         window->setController(controller.get());
 
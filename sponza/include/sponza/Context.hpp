@@ -4,6 +4,7 @@
 #include <vector>
 #include <chrono>
 #include <memory>
+#include <functional>
 
 namespace sponza {
 
@@ -15,8 +16,50 @@ public:
 
     ~Context();
 
+    /**
+     * Updates the scene to the time given by the clock (the wall clock
+     * unless another clock has been set).
+     */
     void update();
 
+    /**
+     * Updates the scene to an explicit time rather than the wall clock, so
+     * the same time always produces the same scene.
+     */
+    void update(float time_seconds);
+
+    /**
+     * Updates the scene to the previous update's time plus a delta.
+     */
+    void advance(float delta_seconds);
+
+    /**
+     * Replaces the clock read by update(), returning the time in seconds.
+     */
+    void setClock(std::function<float()> clock);
+
+    /**
+     * Simulates in fixed steps of the given length, presenting the state
+     * interpolated between the last two steps. Zero simulates once per
+     * update at the update's time (the default).
+     */
+    void setFixedTimestep(float step_seconds);
+
+    float getFixedTimestep() const;
+
+    /**
+     * How far the presented state is between the last two fixed steps.
+     */
+    float getInterpolationAlpha() const;
+
+    /**
+     * Replaces how the per-light and per-instance loops of an update are
+     * run, the function must call body(begin, end) over all of [0, count).
+     * By default the loops run serially on the updating thread.
+     */
+    void setParallelFor(std::function<void(size_t count,
+        const std::function<void(size_t begin, size_t end)>& body)> parallel_for);
+
     bool toggleCameraAnimation();
 
     float getTimeInSeconds() const;
@@ -45,12 +88,45 @@ public:
 
     const std::vector<InstanceId> getInstancesByMeshId(MeshId id) const;
 
+    /**
+     * The bytes allocated by the scene's arrays and simulation snapshots,
+     * so an application can account for the memory the scene holds.
+     */
+    size_t getAllocatedBytes() const;
+
 private:
 
+    struct Snapshot
+    {
+        Vector3 camera_position;
+        Vector3 camera_direction;
+        std::vector<Vector3> point_light_positions;
+        std::vector<Vector3> spot_light_positions;
+        std::vector<Vector3> spot_light_directions;
+        std::vector<Matrix4x3> dynamic_instance_xforms;
+    };
+
     bool readFile(std::string filepath);
 
+    void simulate(float time_seconds);
+
+    void takeSnapshot(Snapshot& snapshot) const;
+
+    void present(const Snapshot& from, const Snapshot& to, float alpha);
+
     std::chrono::system_clock::time_point start_time_;
+    std::function<float()> clock_;
+    std::function<void(size_t,
+        const std::function<void(size_t, size_t)>&)> parallel_for_;
     float time_seconds_;
+    float sim_time_seconds_;
+    float frame_time_seconds_;
+
+    float fixed_step_seconds_;
+    float accumulator_seconds_;
+    float interpolation_alpha_;
+    Snapshot previous_snapshot_;
+    Snapshot current_snapshot_;
 
     std::shared_ptr<FirstPersonMovement> camera_movement_;
     Camera camera_;
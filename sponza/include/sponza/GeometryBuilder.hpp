@@ -3,6 +3,7 @@
 #include "sponza_fwd.hpp"
 #include <string>
 #include <vector>
+#include <functional>
 
 namespace sponza {
 
@@ -12,6 +13,13 @@ public:
 
     GeometryBuilder();
 
+    /**
+     * Converts the meshes with the given parallel-for, which must call
+     * body(begin, end) over all of [0, count).
+     */
+    explicit GeometryBuilder(std::function<void(size_t count,
+        const std::function<void(size_t begin, size_t end)>& body)> parallel_for);
+
     ~GeometryBuilder();
 
     const std::vector<Mesh>& getAllMeshes() const;
@@ -20,7 +28,9 @@ public:
 
 private:
 
-    bool readFile(std::string filepath);
+    bool readFile(std::string filepath,
+                  const std::function<void(size_t,
+                      const std::function<void(size_t, size_t)>&)>& parallel_for);
 
     std::vector<Mesh> meshes_;
 
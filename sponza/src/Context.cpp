@@ -36,10 +36,46 @@ Vector3 operator-(const Vector3& lhs, const Vector3& rhs)
     return Vector3(lhs.x - rhs.x, lhs.y - rhs.y, lhs.z - rhs.z);
 }
 
+static float lerp(float a, float b, float t)
+{
+    return a + (b - a) * t;
+}
+
+static Vector3 lerp(const Vector3& a, const Vector3& b, float t)
+{
+    return Vector3(lerp(a.x, b.x, t), lerp(a.y, b.y, t), lerp(a.z, b.z, t));
+}
+
+static Matrix4x3 lerp(const Matrix4x3& a, const Matrix4x3& b, float t)
+{
+    return Matrix4x3(lerp(a.m00, b.m00, t), lerp(a.m01, b.m01, t), lerp(a.m02, b.m02, t),
+                     lerp(a.m10, b.m10, t), lerp(a.m11, b.m11, t), lerp(a.m12, b.m12, t),
+                     lerp(a.m20, b.m20, t), lerp(a.m21, b.m21, t), lerp(a.m22, b.m22, t),
+                     lerp(a.m30, b.m30, t), lerp(a.m31, b.m31, t), lerp(a.m32, b.m32, t));
+}
+
 Context::Context()
 {
     start_time_ = std::chrono::system_clock::now();
+    clock_ = [this]()
+    {
+        const auto clock_time = std::chrono::system_clock::now() - start_time_;
+        const auto clock_millisecs
+            = std::chrono::duration_cast<std::chrono::milliseconds>(clock_time);
+        return 0.001f * clock_millisecs.count();
+    };
+    parallel_for_ = [](size_t count,
+                       const std::function<void(size_t, size_t)>& body)
+    {
+        body(0, count);
+    };
     time_seconds_ = 0.f;
+    sim_time_seconds_ = 0.f;
+    frame_time_seconds_ = 0.f;
+
+    fixed_step_seconds_ = 0.f;
+    accumulator_seconds_ = 0.f;
+    interpolation_alpha_ = 1.f;
 
     if (!readFile("sponza_with_friends_2x.tcf")) {
         throw std::runtime_error("Failed to read sponza.tcf data file");
@@ -169,12 +205,131 @@ bool Context::readFile(std::string filepath)
 
 void Context::update()
 {
-    const auto clock_time = std::chrono::system_clock::now() - start_time_;
-    const auto clock_millisecs
-        = std::chrono::duration_cast<std::chrono::milliseconds>(clock_time);
-    const float prev_time = time_seconds_;
-    time_seconds_ = 0.001f * clock_millisecs.count();
-    const float dt = time_seconds_ - prev_time;
+    update(clock_());
+}
+
+void Context::update(float time_seconds)
+{
+    const float frame_dt = time_seconds - frame_time_seconds_;
+    frame_time_seconds_ = time_seconds;
+
+    if (fixed_step_seconds_ <= 0.f) {
+        simulate(time_seconds);
+        interpolation_alpha_ = 1.f;
+        return;
+    }
+
+    // step the simulation at the fixed rate, dropping time rather than
+    // falling further behind when too many steps are due at once
+    const int max_steps = 8;
+    accumulator_seconds_ += frame_dt;
+    int steps = 0;
+    while (accumulator_seconds_ >= fixed_step_seconds_ && steps < max_steps) {
+        previous_snapshot_ = std::move(current_snapshot_);
+        simulate(sim_time_seconds_ + fixed_step_seconds_);
+        takeSnapshot(current_snapshot_);
+        accumulator_seconds_ -= fixed_step_seconds_;
+        ++steps;
+    }
+    if (steps == max_steps) {
+        accumulator_seconds_ = fmodf(accumulator_seconds_, fixed_step_seconds_);
+    }
+    if (previous_snapshot_.point_light_positions.empty()) {
+        previous_snapshot_ = current_snapshot_;
+    }
+
+    interpolation_alpha_ = accumulator_seconds_ / fixed_step_seconds_;
+    present(previous_snapshot_, current_snapshot_, interpolation_alpha_);
+    time_seconds_ = sim_time_seconds_
+        - fixed_step_seconds_ * (1.f - interpolation_alpha_);
+}
+
+void Context::advance(float delta_seconds)
+{
+    update(frame_time_seconds_ + delta_seconds);
+}
+
+void Context::setClock(std::function<float()> clock)
+{
+    clock_ = std::move(clock);
+}
+
+void Context::setParallelFor(std::function<void(size_t count,
+    const std::function<void(size_t begin, size_t end)>& body)> parallel_for)
+{
+    parallel_for_ = std::move(parallel_for);
+}
+
+void Context::setFixedTimestep(float step_seconds)
+{
+    fixed_step_seconds_ = step_seconds > 0.f ? step_seconds : 0.f;
+    accumulator_seconds_ = 0.f;
+    takeSnapshot(current_snapshot_);
+    previous_snapshot_ = current_snapshot_;
+}
+
+float Context::getFixedTimestep() const
+{
+    return fixed_step_seconds_;
+}
+
+float Context::getInterpolationAlpha() const
+{
+    return interpolation_alpha_;
+}
+
+void Context::takeSnapshot(Snapshot& snapshot) const
+{
+    snapshot.camera_position = camera_.getPosition();
+    snapshot.camera_direction = camera_.getDirection();
+    snapshot.point_light_positions.clear();
+    for (const auto& light : point_lights_) {
+        snapshot.point_light_positions.push_back(light.getPosition());
+    }
+    snapshot.spot_light_positions.clear();
+    snapshot.spot_light_directions.clear();
+    for (const auto& light : spot_lights_) {
+        snapshot.spot_light_positions.push_back(light.getPosition());
+        snapshot.spot_light_directions.push_back(light.getDirection());
+    }
+    snapshot.dynamic_instance_xforms.clear();
+    for (const auto& instance : instances_) {
+        if (instance.isStatic()) continue;
+        snapshot.dynamic_instance_xforms.push_back(
+            instance.getTransformationMatrix());
+    }
+}
+
+void Context::present(const Snapshot& from, const Snapshot& to, float alpha)
+{
+    camera_.setPosition(lerp(from.camera_position, to.camera_position, alpha));
+    camera_.setDirection(normalize(
+        lerp(from.camera_direction, to.camera_direction, alpha)));
+    for (size_t i = 0; i < point_lights_.size(); ++i) {
+        point_lights_[i].setPosition(lerp(from.point_light_positions[i],
+            to.point_light_positions[i], alpha));
+    }
+    for (size_t i = 0; i < spot_lights_.size(); ++i) {
+        spot_lights_[i].setPosition(lerp(from.spot_light_positions[i],
+            to.spot_light_positions[i], alpha));
+        spot_lights_[i].setDirection(normalize(lerp(
+            from.spot_light_directions[i], to.spot_light_directions[i], alpha)));
+    }
+    size_t dynamic_index = 0;
+    for (auto& instance : instances_) {
+        if (instance.isStatic()) continue;
+        instance.setTransformationMatrix(lerp(
+            from.dynamic_instance_xforms[dynamic_index],
+            to.dynamic_instance_xforms[dynamic_index], alpha));
+        ++dynamic_index;
+    }
+}
+
+void Context::simulate(float time_seconds)
+{
+    const float dt = time_seconds - sim_time_seconds_;
+    sim_time_seconds_ = time_seconds;
+    time_seconds_ = time_seconds;
 
     if (animate_camera_) {
         const float t = -0.3f * time_seconds_;
@@ -229,12 +384,15 @@ void Context::update()
         }
     }
 
-    for (int i = 0; i < num_of_point_lights; ++i)
+    parallel_for_(num_of_point_lights, [&](size_t begin, size_t end)
     {
-        auto& light = point_lights_[i];
-		float A = time_seconds_ + i * 6.28f / num_of_point_lights;
-        light.setPosition(Vector3(120.f * cosf(A), 10.f, 40.f * sinf(A)));
-    }
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& light = point_lights_[i];
+            float A = time_seconds_ + i * 6.28f / num_of_point_lights;
+            light.setPosition(Vector3(120.f * cosf(A), 10.f, 40.f * sinf(A)));
+        }
+    });
 
     const int num_of_spot_lights = 5;
     if (spot_lights_.empty())
@@ -275,15 +433,19 @@ void Context::update()
     spot_lights_[1].setPosition(Vector3(-75.f, 110.f, -5.f + 15.f * cosf(1 + t)));
     spot_lights_[1].setDirection(normalize(Vector3(40.f, 0.f, -5.f) - spot_lights_[1].getPosition()));
 
-    for (auto& instance : instances_)
+    parallel_for_(instances_.size(), [&](size_t begin, size_t end)
     {
-        if (instance.getMeshId() != 300) continue;
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& instance = instances_[i];
+            if (instance.getMeshId() != 300) continue;
 
-        auto xform = instance.getTransformationMatrix();
-        const float bounce_y = 4;
-        xform.m31 = 6.6f + bounce_y * (0.5f + 0.5f * cosf(t));
-        instance.setTransformationMatrix(xform);
-    }
+            auto xform = instance.getTransformationMatrix();
+            const float bounce_y = 4;
+            xform.m31 = 6.6f + bounce_y * (0.5f + 0.5f * cosf(t));
+            instance.setTransformationMatrix(xform);
+        }
+    });
 }
 
 bool Context::toggleCameraAnimation()
@@ -355,3 +517,23 @@ const std::vector<InstanceId> Context::getInstancesByMeshId(MeshId id) const
 {
     return instances_by_mesh_[id - 300];
 }
+
+size_t Context::getAllocatedBytes() const
+{
+    size_t bytes = directional_lights_.capacity() * sizeof(DirectionalLight)
+        + point_lights_.capacity() * sizeof(PointLight)
+        + spot_lights_.capacity() * sizeof(SpotLight)
+        + materials_.capacity() * sizeof(Material)
+        + instances_.capacity() * sizeof(Instance)
+        + instances_by_mesh_.capacity() * sizeof(std::vector<InstanceId>);
+    for (const auto& instances : instances_by_mesh_) {
+        bytes += instances.capacity() * sizeof(InstanceId);
+    }
+    for (const Snapshot* snapshot : { &previous_snapshot_, &current_snapshot_ }) {
+        bytes += (snapshot->point_light_positions.capacity()
+            + snapshot->spot_light_positions.capacity()
+            + snapshot->spot_light_directions.capacity()) * sizeof(Vector3)
+            + snapshot->dynamic_instance_xforms.capacity() * sizeof(Matrix4x3);
+    }
+    return bytes;
+}
@@ -18,8 +18,18 @@ using namespace sponza;
 *****************************************************************************/
 
 GeometryBuilder::GeometryBuilder()
+    : GeometryBuilder([](size_t count,
+                         const std::function<void(size_t, size_t)>& body)
+                      {
+                          body(0, count);
+                      })
 {
-    if (!readFile("sponza_with_friends_2x.tcf")) {
+}
+
+GeometryBuilder::GeometryBuilder(std::function<void(size_t,
+    const std::function<void(size_t, size_t)>&)> parallel_for)
+{
+    if (!readFile("sponza_with_friends_2x.tcf", parallel_for)) {
         throw std::runtime_error("Failed to read sponza.tcf data file");
     }
 }
@@ -39,7 +49,9 @@ const Mesh& GeometryBuilder::getMeshById(MeshId id) const
     return meshes_[id - 300];
 }
 
-bool GeometryBuilder::readFile(std::string filepath)
+bool GeometryBuilder::readFile(std::string filepath,
+                               const std::function<void(size_t,
+                                   const std::function<void(size_t, size_t)>&)>& parallel_for)
 {
     tcf::Reader * reader = tcf::createReader();
     tcf::SimpleScene * tcf_scene = nullptr;
@@ -65,36 +77,43 @@ bool GeometryBuilder::readFile(std::string filepath)
 
     meshes_.reserve(tcf_scene->meshCount());
     for (unsigned int i = 0; i < tcf_scene->meshCount(); ++i) {
-        const auto * mesh = tcf_scene->findMeshByIndex(i);
-        Mesh new_mesh(300 + meshes_.size());
-        if (mesh->indexArray() != nullptr) {
-            new_mesh.assignElementArray(std::vector<unsigned int>(
-                mesh->indexArray(),
-                mesh->indexArray() + mesh->indexCount()));
-        }
-        if (mesh->positionArray() != nullptr) {
-            new_mesh.assignPositionArray(std::vector<Vector3>(
-                (const Vector3 *)mesh->positionArray(),
-                (const Vector3 *)mesh->positionArray() + mesh->vertexCount()));
-        }
-        if (mesh->normalArray() != nullptr) {
-            new_mesh.assignNormalArray(std::vector<Vector3>(
-                (const Vector3 *)mesh->normalArray(),
-                (const Vector3 *)mesh->normalArray() + mesh->vertexCount()));
-        }
-        if (mesh->tangentArray() != nullptr) {
-            new_mesh.assignTangentArray(std::vector<Vector3>(
-                (const Vector3 *)mesh->tangentArray(),
-                (const Vector3 *)mesh->tangentArray() + mesh->vertexCount()));
-        }
-        if (mesh->uvArray() != nullptr) {
-            new_mesh.assignTextureCoordinateArray(std::vector<Vector2>(
-                (const Vector2 *)mesh->uvArray(),
-                (const Vector2 *)mesh->uvArray() + mesh->vertexCount()));
-        }
-        meshes_.push_back(new_mesh);
+        meshes_.push_back(Mesh(300 + i));
     }
 
+    // each mesh only touches its own arrays, so they convert independently
+    parallel_for(meshes_.size(), [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i) {
+            const auto * mesh = tcf_scene->findMeshByIndex(i);
+            Mesh& new_mesh = meshes_[i];
+            if (mesh->indexArray() != nullptr) {
+                new_mesh.assignElementArray(std::vector<unsigned int>(
+                    mesh->indexArray(),
+                    mesh->indexArray() + mesh->indexCount()));
+            }
+            if (mesh->positionArray() != nullptr) {
+                new_mesh.assignPositionArray(std::vector<Vector3>(
+                    (const Vector3 *)mesh->positionArray(),
+                    (const Vector3 *)mesh->positionArray() + mesh->vertexCount()));
+            }
+            if (mesh->normalArray() != nullptr) {
+                new_mesh.assignNormalArray(std::vector<Vector3>(
+                    (const Vector3 *)mesh->normalArray(),
+                    (const Vector3 *)mesh->normalArray() + mesh->vertexCount()));
+            }
+            if (mesh->tangentArray() != nullptr) {
+                new_mesh.assignTangentArray(std::vector<Vector3>(
+                    (const Vector3 *)mesh->tangentArray(),
+                    (const Vector3 *)mesh->tangentArray() + mesh->vertexCount()));
+            }
+            if (mesh->uvArray() != nullptr) {
+                new_mesh.assignTextureCoordinateArray(std::vector<Vector2>(
+                    (const Vector2 *)mesh->uvArray(),
+                    (const Vector2 *)mesh->uvArray() + mesh->vertexCount()));
+            }
+        }
+    });
+
     reader->release();
     tcf_scene->release();
 